@@ -7,14 +7,16 @@
 
 #include "client.hpp"
 #include "state.hpp"
-#include "render.hpp"
-#include "inputs.hpp"
 #include "../common/debug.hpp"
+#include "../common/packet_io.hpp"
+#include "../common/messages.hpp"
 
 Client::Client(const std::string& server_ip, int server_port, bool debug_mode)
     : client_fd(-1), server_ip(server_ip), server_port(server_port), debug_mode(debug_mode),
-      game_started(false), game_over(false), connected(false), my_player_number(-1),
-      running(false), game_state(nullptr) {
+      loaded_columns(0), game_started(false), game_over(false), connected(false), my_player_number(-1),
+      running(false), reader(BUFFER_SIZE, Protocol::MAX_PAYLOAD_SIZE), latest_state_type(0), udp_fd(-1),
+      udp_token(0), udp_send_sequence(0), udp_recv_sequence(0), udp_ready(false),
+      jet_state(false), last_snapshot_sequence(0), coin_sync_needed(false), game_state(nullptr) {
     g_logger.setDebugMode(debug_mode);
 }
 
@@ -25,6 +27,9 @@ Client::~Client()
     if (client_fd >= 0) {
         close(client_fd);
     }
+
+    if (udp_fd >= 0)
+        close(udp_fd);
 }
 
 bool Client::initialize()
@@ -47,9 +52,10 @@ bool Client::connectToServer()
     DEBUG_LOG("Connected to server: " + server_ip + ":" + std::to_string(server_port));
 
     setSocketNonBlocking();
-    sendConnectMessage();
 
+    // sendToServer() drops everything until then
     connected = true;
+    sendConnectMessage();
     return true;
 }
 
@@ -75,36 +81,15 @@ void Client::setSocketNonBlocking()
 
 void Client::sendConnectMessage()
 {
-    std::vector<uint8_t> payload;
-    std::vector<uint8_t> packet = Protocol::createPacket(MSG_CONNECT, payload);
+    auto packet = ConnectSchema::packet({ CAP_DELTA_STATE | CAP_UDP | CAP_MAP_CHUNKS });
 
-    sendToServer(packet);
+    sendToServer(packet.data(), packet.size());
 }
 
-void Client::run(InputManager &input, Renderer &renderer)
+void Client::startNetwork()
 {
     running = true;
     network_thread = std::thread(&Client::networkLoop, this);
-
-    while (running) {
-        if (game_started.load(std::memory_order_acquire)) {
-            DEBUG_LOG("Game is started in main loop: " + std::to_string(game_started.load()));
-        }
-
-        input.processInputs();
-        renderer.render();
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-
-        if (game_over) {
-            if (input.shouldExit()) {
-                running = false;
-            }
-        }
-    }
-
-    if (network_thread.joinable()) {
-        network_thread.join();
-    }
 }
 
 void Client::stop()
@@ -135,41 +120,159 @@ void Client::networkLoop()
 void Client::processOutgoingMessages()
 {
     std::lock_guard<std::mutex> lock(queue_mutex);
+    std::vector<uint8_t> udp_messages;
+    bool udp_has_input = false;
 
     while (!message_queue.empty()) {
         const auto& message = message_queue.front();
-        send(client_fd, message.data(), message.size(), 0);
+        uint8_t type = message[0];
 
-        DEBUG_PACKET_SEND(reinterpret_cast<const char*>(message.data()), message.size());
+        if (udp_ready && (type == MSG_PLAYER_INPUT || type == MSG_STATE_ACK)) {
+            udp_messages.insert(udp_messages.end(), message.begin(), message.end());
+            udp_has_input |= type == MSG_PLAYER_INPUT;
+        } else {
+            send(client_fd, message.data(), message.size(), MSG_NOSIGNAL);
+            DEBUG_PACKET_SEND(reinterpret_cast<const char*>(message.data()), message.size());
+        }
 
         message_queue.pop();
     }
+
+    // Datagrams get lost, every ack repeats the jetpack state with it
+    if (!udp_messages.empty()) {
+        if (!udp_has_input) {
+            auto input = PlayerInputSchema::packet({ jet_state.load() });
+
+            udp_messages.insert(udp_messages.end(), input.begin(), input.end());
+        }
+        sendUdpDatagram(udp_messages);
+    }
+
+    if (udp_fd >= 0 && !udp_ready) {
+        auto now = std::chrono::steady_clock::now();
+
+        if (now - last_udp_hello >= std::chrono::milliseconds(UDP_HELLO_INTERVAL_MS)) {
+            sendUdpDatagram(Protocol::createPacket(MSG_UDP_HELLO, {}));
+            last_udp_hello = now;
+        }
+    }
+}
+
+void Client::sendUdpDatagram(const std::vector<uint8_t> &messages)
+{
+    std::vector<uint8_t> datagram(UdpClientPrefixSchema::SIZE + messages.size());
+    PacketWriter writer(datagram);
+
+    udp_send_sequence++;
+    writer.write<UdpClientPrefixSchema>({ udp_token, udp_send_sequence });
+    writer.bytes(messages.data(), messages.size());
+    send(udp_fd, datagram.data(), writer.finish(), 0);
 }
 
 void Client::readIncomingData()
 {
-    memset(recv_buffer, 0, BUFFER_SIZE);
-    ssize_t bytes_read = recv(client_fd, recv_buffer, BUFFER_SIZE, 0);
+    // Drain the socket, one recv per loop fell behind as soon as the
+    // server sent more than one message per 10 ms
+    while (true) {
+        ssize_t bytes_read = reader.readFrom(client_fd);
+        int read_errno = errno;
+
+        if (bytes_read == 0 || (bytes_read < 0 && read_errno != EAGAIN &&
+            read_errno != EWOULDBLOCK && read_errno != ENOBUFS)) {
+            connected = false;
+            running = false;
+            return;
+        }
 
-    if (bytes_read > 0) {
-        DEBUG_PACKET_RECV(recv_buffer, bytes_read);
+        drainFrames();
 
-        MessageHeader header;
+        if (!running || (bytes_read < 0 && read_errno != ENOBUFS))
+            break;
+    }
 
-        if (Protocol::parseHeader(recv_buffer, bytes_read, header)) {
-            if (header.type == MSG_GAME_START) {
-                handleGameStart();
-                return;
-            }
-            processMessage(header, recv_buffer + sizeof(MessageHeader),
-                          bytes_read - sizeof(MessageHeader));
-        }
-    } else if (bytes_read == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+    if (udp_fd >= 0)
+        readUdpData();
+
+    applyLatestState();
+}
+
+void Client::drainFrames()
+{
+    FrameReader::Frame frame;
+    FrameReader::Result result;
+
+    while ((result = reader.next(frame)) == FrameReader::FRAME_READY) {
+        const char *data = reinterpret_cast<const char *>(frame.payload);
+
+        DEBUG_LOG("Received message type " + std::to_string(frame.header.type) +
+                  ", size " + std::to_string(frame.size));
+
+        if (frame.header.type == MSG_GAME_START)
+            handleGameStart(data, frame.size);
+        else if (frame.header.type == MSG_GAME_STATE || frame.header.type == MSG_GAME_STATE_DELTA)
+            keepLatestState(frame.header.type, frame.payload, frame.size);
+        else
+            processMessage(frame.header, data, frame.size);
+    }
+
+    if (result == FrameReader::FRAME_TOO_LARGE) {
         connected = false;
         running = false;
     }
 }
 
+void Client::readUdpData()
+{
+    uint8_t buffer[UDP_BUFFER_SIZE];
+    ssize_t bytes_read;
+
+    while ((bytes_read = recv(udp_fd, buffer, UDP_BUFFER_SIZE, 0)) > 0) {
+        UdpServerPrefix prefix;
+        MessageHeader header;
+        size_t size = static_cast<size_t>(bytes_read);
+        const uint8_t *packet = buffer + UdpServerPrefixSchema::SIZE;
+
+        if (!UdpServerPrefixSchema::decode(buffer, size, prefix) ||
+            !Protocol::parseHeader(reinterpret_cast<const char *>(packet), size - UdpServerPrefixSchema::SIZE, header))
+            continue;
+
+        uint32_t payload_size = Protocol::getPayloadSize(header);
+
+        // Reordered or duplicated by the network
+        if (prefix.sequence <= udp_recv_sequence ||
+            UdpServerPrefixSchema::SIZE + sizeof(MessageHeader) + payload_size > size)
+            continue;
+
+        udp_recv_sequence = prefix.sequence;
+
+        if (header.type == MSG_GAME_STATE || header.type == MSG_GAME_STATE_DELTA) {
+            keepLatestState(header.type, packet + sizeof(MessageHeader), payload_size);
+            stats.udp_states++;
+        }
+    }
+}
+
+void Client::keepLatestState(uint8_t type, const uint8_t *data, size_t data_size)
+{
+    latest_state_type = type;
+    latest_state.assign(data, data + data_size);
+}
+
+void Client::applyLatestState()
+{
+    if (latest_state_type == 0)
+        return;
+
+    const char *data = reinterpret_cast<const char *>(latest_state.data());
+
+    if (latest_state_type == MSG_GAME_STATE)
+        handleGameState(data, latest_state.size());
+    else
+        handleGameStateDelta(data, latest_state.size());
+
+    latest_state_type = 0;
+}
+
 
 void Client::processMessage(const MessageHeader &header, const char *data, size_t data_size)
 {
@@ -185,15 +288,34 @@ void Client::processMessage(const MessageHeader &header, const char *data, size_
         case MSG_MAP_DATA:
             handleMapData(data, payload_size);
             break;
+        case MSG_MAP_INFO:
+            handleMapInfo(data, payload_size);
+            break;
+        case MSG_MAP_CHUNK:
+            handleMapChunk(data, payload_size);
+            break;
         case MSG_GAME_STATE:
             handleGameState(data, payload_size);
             break;
+        case MSG_GAME_STATE_DELTA:
+            handleGameStateDelta(data, payload_size);
+            break;
         case MSG_COLLISION:
             handleCollision(data, payload_size);
             break;
+        case MSG_COIN_SYNC:
+            handleCoinSync(data, payload_size);
+            break;
         case MSG_GAME_END:
             handleGameEnd(data, payload_size);
             break;
+        case MSG_UDP_OFFER:
+            handleUdpOffer(data, payload_size);
+            break;
+        case MSG_UDP_READY:
+            DEBUG_LOG("UDP channel ready, game state now comes by datagram");
+            udp_ready = true;
+            break;
         case MSG_COUNTDOWN:
             if (payload_size >= 1) {
                 int count = data[0];
@@ -215,17 +337,90 @@ void Client::handleMapData(const char *data, size_t size)
     std::vector<uint8_t> map_data(data, data + size);
 
     if (game_map.loadFromData(map_data)) {
+        loaded_columns.store(game_map.getWidth(), std::memory_order_release);
         DEBUG_LOG("Map loaded successfully: " + std::to_string(game_map.getWidth()) +
                   "x" + std::to_string(game_map.getHeight()));
+        requestCoinSyncIfNeeded();
     } else {
         DEBUG_LOG("Failed to load map data");
     }
 }
 
-void Client::handleGameStart()
+void Client::handleMapInfo(const char *data, size_t size)
+{
+    loaded_columns.store(0, std::memory_order_release);
+
+    if (!game_map.loadInfo(reinterpret_cast<const uint8_t *>(data), size))
+        DEBUG_LOG("Failed to load map info");
+}
+
+void Client::handleMapChunk(const char *data, size_t size)
+{
+    size_t end_column = 0;
+
+    if (!game_map.loadChunk(reinterpret_cast<const uint8_t *>(data), size, end_column)) {
+        DEBUG_LOG("Failed to load map chunk");
+        return;
+    }
+
+    // Chunks come in order over TCP, so the loaded columns stay contiguous
+    if (end_column > loaded_columns.load(std::memory_order_relaxed))
+        loaded_columns.store(end_column, std::memory_order_release);
+
+    if (end_column == game_map.getWidth()) {
+        DEBUG_LOG("Map loaded successfully: " + std::to_string(game_map.getWidth()) +
+                  "x" + std::to_string(game_map.getHeight()));
+        requestCoinSyncIfNeeded();
+    }
+}
+
+void Client::handleUdpOffer(const char *data, size_t size)
+{
+    UdpOfferMessage offer;
+
+    if (!UdpOfferSchema::decode(reinterpret_cast<const uint8_t *>(data), size, offer))
+        return;
+
+    // A new offer replaces the channel, the server moved us to another shard
+    if (udp_fd >= 0) {
+        close(udp_fd);
+        udp_fd = -1;
+        udp_ready = false;
+        udp_send_sequence = 0;
+        udp_recv_sequence = 0;
+    }
+
+    struct sockaddr_in udp_addr = setupServerAddress();
+    udp_addr.sin_port = htons(offer.port);
+    udp_token = offer.token;
+
+    udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (udp_fd < 0)
+        return;
+
+    // Without the UDP channel, everything keeps coming over TCP
+    if (connect(udp_fd, (struct sockaddr*)&udp_addr, sizeof(udp_addr)) < 0) {
+        close(udp_fd);
+        udp_fd = -1;
+        return;
+    }
+
+    fcntl(udp_fd, F_SETFL, fcntl(udp_fd, F_GETFL, 0) | O_NONBLOCK);
+    DEBUG_LOG("UDP channel offered on port " + std::to_string(ntohs(udp_addr.sin_port)));
+}
+
+void Client::handleGameStart(const char *data, size_t size)
 {
     DEBUG_LOG("Game start received, beginning countdown");
 
+    GameStartMessage start;
+
+    // Older servers sent an empty payload
+    if (GameStartSchema::decode(reinterpret_cast<const uint8_t *>(data), size, start)) {
+        my_player_number = start.player_number;
+        DEBUG_LOG("Server assigned me player number: " + std::to_string(my_player_number));
+    }
+
     std::thread([this]() {
         for (int i = 3; i > 0; i--) {
             DEBUG_LOG("Game starting in " + std::to_string(i) + "...");
@@ -243,14 +438,15 @@ void Client::handleGameState(const char *data, size_t size)
 
     std::lock_guard<std::mutex> lock(data_mutex);
 
-    size_t pos = 0;
+    StateRecords::decode(reinterpret_cast<const uint8_t *>(data), size, state_records);
+    stats.full_states++;
 
-    while (pos + 8 <= size) {
-        int player_number = data[pos++];
-        uint16_t x = (data[pos] << 8) | data[pos+1]; pos += 2;
-        uint16_t y = (data[pos] << 8) | data[pos+1]; pos += 2;
-        uint16_t score = (data[pos] << 8) | data[pos+1]; pos += 2;
-        bool jet_active = data[pos++] != 0;
+    for (const PlayerSnapshot &record : state_records) {
+        int player_number = record.player_number;
+        uint16_t x = record.x;
+        uint16_t y = record.y;
+        uint16_t score = record.score;
+        bool jet_active = record.jet_active;
 
         if (my_player_number == -1) {
             my_player_number = player_number;
@@ -266,29 +462,128 @@ void Client::handleGameState(const char *data, size_t size)
     }
 }
 
+void Client::handleGameStateDelta(const char *data, size_t size)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+    uint32_t sequence;
+    uint32_t baseline_sequence;
+
+    if (!game_state || !SnapshotCodec::readSequences(bytes, size, sequence, baseline_sequence))
+        return;
+
+    // Older than what we already have, nothing to learn from it
+    if (sequence <= last_snapshot_sequence)
+        return;
+
+    const Snapshot *baseline = snapshot_history.find(baseline_sequence);
+
+    if (!SnapshotCodec::decode(baseline, bytes, size, decoded_snapshot)) {
+        DEBUG_LOG("Cannot decode snapshot " + std::to_string(sequence) +
+                  " against baseline " + std::to_string(baseline_sequence));
+        return;
+    }
+
+    snapshot_history.store(decoded_snapshot);
+    last_snapshot_sequence = sequence;
+    stats.delta_states++;
+    if (baseline)
+        stats.baselined_states++;
+
+    {
+        std::lock_guard<std::mutex> lock(data_mutex);
+
+        for (const auto &player : decoded_snapshot.players) {
+            game_state->updatePlayer(player.player_number, player.x, player.y,
+                                     player.score, player.jet_active);
+        }
+    }
+
+    sendStateAck(sequence);
+}
+
+void Client::sendStateAck(uint32_t sequence)
+{
+    auto packet = StateAckSchema::packet({ sequence });
+
+    sendToServer(packet.data(), packet.size());
+    stats.state_acks++;
+}
+
 void Client::handleCollision(const char *data, size_t size)
 {
-    if (size < 5)
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+    CollisionMessage collision;
+    int player_number = -1;
+
+    // Older servers do not say who collided
+    if (CollisionSchema::decode(bytes, size, collision))
+        player_number = collision.player_number;
+    else if (!LegacyCollisionSchema::decode(bytes, size, collision))
         return;
 
-    char collision_type = data[0];
-    uint16_t x = (data[1] << 8) | data[2];
-    uint16_t y = (data[3] << 8) | data[4];
+    char collision_type = collision.type;
+    uint16_t x = collision.x;
+    uint16_t y = collision.y;
 
     DEBUG_LOG("Collision: type=" + std::string(1, collision_type) +
               ", position=(" + std::to_string(x) + "," + std::to_string(y) + ")");
 
-    if (game_state)
-        game_state->handleCollision(collision_type, x, y);
+    if (!game_state)
+        return;
+
+    game_state->handleCollision(collision_type, x, y);
+
+    if (collision_type != 'c' || player_number != my_player_number)
+        return;
+
+    uint32_t index = 0;
+
+    // The coin index only exists once the whole map is there
+    if (game_map.getCoinIndex(x, y, index))
+        game_state->collectCoin(index);
+    else
+        coin_sync_needed = true;
+}
+
+void Client::handleCoinSync(const char *data, size_t size)
+{
+    PacketReader reader(data, size);
+    uint8_t player_number = reader.u8();
+    size_t pos = reader.offset();
+    CoinSet coins;
+
+    if (!reader.ok() || !game_state || player_number != my_player_number)
+        return;
+
+    if (!coins.decode(reinterpret_cast<const uint8_t *>(data), size, pos)) {
+        DEBUG_LOG("Invalid coin sync");
+        return;
+    }
+
+    DEBUG_LOG("Coin sync: " + std::to_string(coins.size()) + " coins collected");
+    game_state->setCollectedCoins(std::move(coins));
+}
+
+void Client::requestCoinSyncIfNeeded()
+{
+    if (!coin_sync_needed)
+        return;
+
+    coin_sync_needed = false;
+    uint8_t packet[sizeof(MessageHeader)];
+    PacketWriter writer(packet, MSG_COIN_SYNC);
+
+    sendToServer(packet, writer.finish());
 }
 
 void Client::handleGameEnd(const char* data, size_t size)
 {
     game_over = true;
 
-    if (size >= 1) {
+    GameEndMessage end;
 
-        int winner = static_cast<uint8_t>(data[0]);
+    if (GameEndSchema::decode(reinterpret_cast<const uint8_t *>(data), size, end)) {
+        int winner = end.winner;
 
         if (winner != 0xFF) {
             DEBUG_LOG("Game over. Player " + std::to_string(winner) + " wins!");
@@ -302,14 +597,14 @@ void Client::handleGameEnd(const char* data, size_t size)
     }
 }
 
-void Client::sendToServer(const std::vector<uint8_t>& data)
+void Client::sendToServer(const uint8_t *data, size_t size)
 {
-    if (!connected || data.empty())
+    if (!connected || size == 0)
         return;
 
     std::lock_guard<std::mutex> lock(queue_mutex);
 
-    message_queue.push(data);
+    message_queue.emplace(data, data + size);
 }
 
 void Client::sendPlayerInput(bool jet_activated)
@@ -317,9 +612,10 @@ void Client::sendPlayerInput(bool jet_activated)
     if (!connected || !game_started || game_over)
         return;
 
-    std::vector<uint8_t> payload = { static_cast<uint8_t>(jet_activated ? 1 : 0) };
-    std::vector<uint8_t> packet = Protocol::createPacket(MSG_PLAYER_INPUT, payload);
+    auto packet = PlayerInputSchema::packet({ jet_activated });
+
+    jet_state = jet_activated;
 
     DEBUG_LOG("Sending input: jet " + std::string(jet_activated ? "ON" : "OFF"));
-    sendToServer(packet);
+    sendToServer(packet.data(), packet.size());
 }
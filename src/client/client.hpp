@@ -26,6 +26,8 @@
 
 #include "../common/map.hpp"
 #include "../common/protocol.hpp"
+#include "../common/snapshot.hpp"
+#include "../common/frame_reader.hpp"
 
 
 class GameState;
@@ -34,6 +36,16 @@ class InputManager;
 
 class Client {
 
+public:
+    // What the network thread got from the server, for jetpack_client_check
+    struct Stats {
+        std::atomic<uint32_t> full_states{0};
+        std::atomic<uint32_t> delta_states{0};
+        std::atomic<uint32_t> baselined_states{0};   // decoded against a snapshot we acked
+        std::atomic<uint32_t> state_acks{0};
+        std::atomic<uint32_t> udp_states{0};
+    };
+
 private:
     int client_fd;
     std::string server_ip;
@@ -41,6 +53,8 @@ private:
     bool debug_mode;
 
     Map game_map;
+    // Columns the renderer may read, the tail of a chunked map may be missing
+    std::atomic<size_t> loaded_columns;
     std::atomic<bool> game_started;
     std::atomic<bool> game_over;
     std::atomic<bool> connected;
@@ -51,7 +65,22 @@ private:
     std::atomic<bool> running;
 
     static const size_t BUFFER_SIZE = 4096;
-    char recv_buffer[BUFFER_SIZE];
+    FrameReader reader;
+
+    // Only the newest game state of a read is worth decoding
+    std::vector<uint8_t> latest_state;
+    uint8_t latest_state_type;
+
+    // UDP channel for game state, offered by servers started with -u
+    static const size_t UDP_BUFFER_SIZE = 1500;
+    static constexpr int UDP_HELLO_INTERVAL_MS = 200;
+    int udp_fd;
+    uint32_t udp_token;
+    uint32_t udp_send_sequence;
+    uint32_t udp_recv_sequence;
+    std::atomic<bool> udp_ready;
+    std::atomic<bool> jet_state;
+    std::chrono::steady_clock::time_point last_udp_hello;
 
     std::mutex data_mutex;
     std::condition_variable data_cv;
@@ -61,8 +90,20 @@ private:
 
     std::chrono::steady_clock::time_point game_end_time;
 
+    // Delta game state: decoded snapshots are kept as baselines
+    SnapshotHistory snapshot_history;
+    Snapshot decoded_snapshot;
+    std::vector<PlayerSnapshot> state_records;
+    uint32_t last_snapshot_sequence;
+
+    // A coin of ours was collected before the map index was there, ask
+    // for a MSG_COIN_SYNC once the map is complete
+    bool coin_sync_needed;
+
     GameState *game_state;
 
+    Stats stats;
+
     bool connectToServer();
     struct sockaddr_in setupServerAddress();
     void setSocketNonBlocking();
@@ -71,13 +112,26 @@ private:
     void networkLoop();
     void processOutgoingMessages();
     void readIncomingData();
+    void drainFrames();
+    void readUdpData();
+    void keepLatestState(uint8_t type, const uint8_t *data, size_t data_size);
+    void applyLatestState();
     void processMessage(const MessageHeader& header, const char *data, size_t data_size);
-    void sendToServer(const std::vector<uint8_t> &data);
+    void sendToServer(const uint8_t *data, size_t size);
+    void sendUdpDatagram(const std::vector<uint8_t> &messages);
+
+    void handleUdpOffer(const char *data, size_t data_size);
 
-    void handleGameStart();
+    void handleGameStart(const char *data, size_t data_size);
     void handleMapData(const char *data, size_t data_size);
+    void handleMapInfo(const char *data, size_t data_size);
+    void handleMapChunk(const char *data, size_t data_size);
     void handleGameState(const char *data, size_t data_size);
+    void handleGameStateDelta(const char *data, size_t data_size);
+    void sendStateAck(uint32_t sequence);
     void handleCollision(const char *data, size_t data_size);
+    void handleCoinSync(const char *data, size_t data_size);
+    void requestCoinSyncIfNeeded();
     void handleGameEnd(const char *data, size_t data_size);
 
 public:
@@ -85,6 +139,9 @@ public:
     ~Client();
 
     bool initialize();
+
+    // Starts the network thread, run() does it before opening the window
+    void startNetwork();
     void run(InputManager &input_manager, Renderer& renderer);
     void forceGameStarted() { game_started = true; }
     void stop();
@@ -95,7 +152,10 @@ public:
     bool isGameStarted() const { return game_started; }
     bool isGameOver() const { return game_over; }
     const Map &getMap() const { return game_map; }
+    size_t getLoadedColumns() const { return loaded_columns.load(std::memory_order_acquire); }
     int getPlayerNumber() const { return my_player_number; }
+    bool isUdpReady() const { return udp_ready; }
+    const Stats &getStats() const { return stats; }
 
     void setGameState(GameState *state) { game_state = state; }
     GameState *getGameState() const { return game_state; }
@@ -0,0 +1,39 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "client.hpp"
+#include "render.hpp"
+#include "inputs.hpp"
+#include "../common/debug.hpp"
+
+// The window side of Client, apart so that client.cpp links without SFML
+// (jetpack_client_check drives it headless)
+
+void Client::run(InputManager &input, Renderer &renderer)
+{
+    startNetwork();
+
+    while (running) {
+        if (game_started.load(std::memory_order_acquire)) {
+            DEBUG_LOG("Game is started in main loop: " + std::to_string(game_started.load()));
+        }
+
+        input.processInputs();
+        renderer.render();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        if (game_over) {
+            if (input.shouldExit()) {
+                running = false;
+            }
+        }
+    }
+
+    if (network_thread.joinable()) {
+        network_thread.join();
+    }
+}
@@ -11,6 +11,7 @@
 #include "../common/debug.hpp"
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 
 Renderer::Renderer(Client* client)
@@ -198,16 +199,29 @@ void Renderer::renderMapTiles(const Map &map)
     int start_x = static_cast<int>(camera_x);
     int end_x = start_x + SCREEN_WIDTH / TILE_SIZE + 1;
 
-    size_t map_width = map.getWidth();
+    // Only what already arrived, the rest of the map may still be on its way
+    size_t map_width = std::min(map.getWidth(), client->getLoadedColumns());
     size_t map_height = map.getHeight();
 
     if (static_cast<size_t>(end_x) > map_width)
         end_x = static_cast<int>(map_width);
 
-    for (size_t y = 0; y < map_height; y++) {
-        for (int x = start_x; x < end_x; x++) {
-            char tile = map.getTile(x, y);
-            renderTile(tile, x, y);
+    // Coins are numbered once the whole map is there, ours are hidden
+    bool complete = map_width == map.getWidth();
+    GameState *state = client->getGameState();
+    CoinSet collected = complete && state ? state->getCollectedCoins() : CoinSet();
+
+    // Column by column, the way the map is stored
+    for (int x = start_x; x < end_x; x++) {
+        std::span<const char> column = map.getColumn(x);
+        // The coin index is built with the last chunk, not there before
+        size_t coin = complete ? map.getFirstCoin(x) : 0;
+
+        for (size_t y = 0; y < map_height; y++) {
+            if (column[y] == 'c' && complete && collected.contains(coin++))
+                continue;
+            if (column[y] != '_')
+                renderTile(column[y], x, y);
         }
     }
 }
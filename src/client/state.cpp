@@ -28,6 +28,20 @@ void GameState::handleCollision(char type, int x, int y)
     effects.emplace_back(type, x, y);
 }
 
+void GameState::collectCoin(uint32_t index)
+{
+    std::lock_guard<std::mutex> lock(state_mutex);
+
+    collected_coins.insert(index);
+}
+
+void GameState::setCollectedCoins(CoinSet coins)
+{
+    std::lock_guard<std::mutex> lock(state_mutex);
+
+    collected_coins = std::move(coins);
+}
+
 void GameState::setWinner(int player_number)
 {
     std::lock_guard<std::mutex> lock(state_mutex);
@@ -54,6 +68,13 @@ std::vector<GameState::CollisionEffect> GameState::getEffects()
     return effects;
 }
 
+CoinSet GameState::getCollectedCoins()
+{
+    std::lock_guard<std::mutex> lock(state_mutex);
+
+    return collected_coins;
+}
+
 void GameState::updateEffects()
 {
     std::lock_guard<std::mutex> lock(state_mutex);
@@ -12,6 +12,7 @@
 #include <mutex>
 #include <vector>
 #include "../common/map.hpp"
+#include "../common/coin_set.hpp"
 
 struct PlayerState {
     int x;
@@ -41,17 +42,23 @@ private:
 
     std::vector<CollisionEffect> effects;
 
+    // Coins this client's player collected, they are not drawn anymore
+    CoinSet collected_coins;
+
 public:
     GameState();
 
     void updatePlayer(int player_number, int x, int y, int score, bool jet_active);
     void handleCollision(char type, int x, int y);
+    void collectCoin(uint32_t index);
+    void setCollectedCoins(CoinSet coins);
     void setWinner(int player_number);
     int getWinner() const;
 
     // mutex
     std::map<int, PlayerState> getPlayers();
     std::vector<CollisionEffect> getEffects();
+    CoinSet getCollectedCoins();
 
     void updateEffects();
 };
@@ -0,0 +1,127 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "coin_set.hpp"
+#include "varint.hpp"
+#include <algorithm>
+
+bool CoinSet::insert(uint32_t index)
+{
+    // The tick path: the coin comes after everything collected so far
+    if (runs.empty() || index > runs.back().first + runs.back().count) {
+        runs.push_back({index, 1});
+        coin_count++;
+        return true;
+    }
+    if (index == runs.back().first + runs.back().count) {
+        runs.back().count++;
+        coin_count++;
+        return true;
+    }
+
+    // First run starting after the coin, the one before may hold it
+    auto next = std::upper_bound(runs.begin(), runs.end(), index,
+        [](uint32_t value, const Run &run) { return value < run.first; });
+
+    if (next != runs.begin()) {
+        auto previous = next - 1;
+
+        if (index < previous->first + previous->count)
+            return false;
+        if (index == previous->first + previous->count) {
+            previous->count++;
+            if (next != runs.end() && next->first == index + 1) {
+                previous->count += next->count;
+                runs.erase(next);
+            }
+            coin_count++;
+            return true;
+        }
+    }
+
+    if (next != runs.end() && next->first == index + 1) {
+        next->first--;
+        next->count++;
+    } else {
+        runs.insert(next, {index, 1});
+    }
+    coin_count++;
+    return true;
+}
+
+bool CoinSet::contains(uint32_t index) const
+{
+    auto next = std::upper_bound(runs.begin(), runs.end(), index,
+        [](uint32_t value, const Run &run) { return value < run.first; });
+
+    if (next == runs.begin())
+        return false;
+    --next;
+    return index < next->first + next->count;
+}
+
+void CoinSet::clear()
+{
+    runs.clear();
+    coin_count = 0;
+}
+
+void CoinSet::encode(std::vector<uint8_t> &out) const
+{
+    uint32_t end = 0;
+
+    Varint::write(out, coin_count);
+    Varint::write(out, runs.size());
+    for (const Run &run : runs) {
+        Varint::write(out, run.first - end);
+        Varint::write(out, run.count);
+        end = run.first + run.count;
+    }
+}
+
+bool CoinSet::decode(const uint8_t *data, size_t size, size_t &pos)
+{
+    uint32_t total = 0;
+    uint32_t run_count = 0;
+    uint64_t end = 0;
+    size_t counted = 0;
+
+    if (!Varint::read(data, size, pos, total) ||
+        !Varint::read(data, size, pos, run_count))
+        return false;
+
+    // Every run takes at least two bytes, do not trust a huge count
+    if (run_count > (size - pos) / 2)
+        return false;
+
+    std::vector<Run> decoded;
+    decoded.reserve(run_count);
+
+    for (uint32_t i = 0; i < run_count; i++) {
+        uint32_t gap = 0;
+        uint32_t count = 0;
+
+        if (!Varint::read(data, size, pos, gap) ||
+            !Varint::read(data, size, pos, count))
+            return false;
+
+        // Runs are sorted, non-empty and do not touch
+        if (count == 0 || (i > 0 && gap == 0) || end + gap + count > UINT32_MAX)
+            return false;
+
+        decoded.push_back({static_cast<uint32_t>(end + gap), count});
+        end += gap + count;
+        counted += count;
+    }
+
+    if (counted != total)
+        return false;
+
+    runs = std::move(decoded);
+    coin_count = total;
+    return true;
+}
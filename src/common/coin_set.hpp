@@ -0,0 +1,50 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef COIN_SET_HPP
+    #define COIN_SET_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Coins collected by one player, by coin index (see Map::getCoinIndex).
+// Stored as sorted runs of consecutive indexes: players only move forward
+// and coins are numbered column by column, so a player's coins come in
+// increasing order and the set costs memory per run of its own coins,
+// never per coin of the map. Adding past the last run is O(1), anything
+// else is a binary search.
+class CoinSet {
+public:
+    struct Run {
+        uint32_t first;
+        uint32_t count;
+    };
+
+private:
+    std::vector<Run> runs;
+    size_t coin_count;
+
+public:
+    CoinSet() : coin_count(0) {}
+
+    // False when the coin was already in the set
+    bool insert(uint32_t index);
+
+    bool contains(uint32_t index) const;
+
+    size_t size() const { return coin_count; }
+    const std::vector<Run> &getRuns() const { return runs; }
+    void clear();
+
+    // Coin count, run count, then per run the gap since the end of the
+    // previous run and the run length, all varints
+    void encode(std::vector<uint8_t> &out) const;
+    bool decode(const uint8_t *data, size_t size, size_t &pos);
+};
+
+#endif
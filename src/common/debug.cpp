@@ -6,52 +6,186 @@
  */
 
 #include "debug.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 
-Logger::Logger(bool debug) : debug_mode(debug)
-{}
+// Retires the ring of a thread when the thread exits, the writer frees it
+// once everything in it was written
+struct RingHandle {
+    std::shared_ptr<LogRing> ring;
 
-void Logger::setDebugMode(bool mode)
+    ~RingHandle()
+    {
+        if (ring)
+            ring->retire();
+    }
+};
+
+Logger::Logger(bool debug) : debug_mode(false), stopping(false)
 {
-    debug_mode = mode;
+    setDebugMode(debug);
 }
 
-bool Logger::isDebugMode() const
+Logger::~Logger()
+{
+    stopping.store(true, std::memory_order_release);
+    if (writer.joinable())
+        writer.join();
+}
+
+void Logger::setDebugMode(bool mode)
 {
-    return debug_mode;
+    if (mode)
+        startWriter();
+    debug_mode.store(mode, std::memory_order_relaxed);
 }
 
 void Logger::log(const std::string &message)
 {
-    if (!debug_mode)
+    if (!isDebugMode())
         return;
 
-    std::lock_guard<std::mutex> lock(log_mutex);
+    push(message.data(), message.size());
+}
+
+void Logger::logPacket(const char *direction, const char *data, size_t size)
+{
+    if (!isDebugMode())
+        return;
+
+    char line[LogRing::MAX_MESSAGE];
+    int length = snprintf(line, sizeof(line), "%s packet: ", direction);
+
+    for (size_t i = 0; i < std::min(size, static_cast<size_t>(16)); i++)
+        length += snprintf(line + length, sizeof(line) - length, "%02x ", data[i] & 0xFF);
 
-    auto now = std::time(nullptr);
-    auto tm = *std::localtime(&now);
+    if (size > 16)
+        length += snprintf(line + length, sizeof(line) - length, "...");
 
-    std::cout << "[" << std::put_time(&tm, "%H:%M:%S") << "] " << message << std::endl;
+    push(line, length);
 }
 
-void Logger::logPacket(const std::string &direction, const char *data, size_t size)
+//=============================================================================
+// Logging threads
+//=============================================================================
+
+LogRing &Logger::threadRing()
 {
-    if (!debug_mode)
-        return;
+    static thread_local RingHandle handle;
 
-    std::lock_guard<std::mutex> lock(log_mutex);
+    // First message of this thread, the only time it takes the lock
+    if (!handle.ring) {
+        handle.ring = std::make_shared<LogRing>();
+
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        rings.push_back(handle.ring);
+    }
+    return *handle.ring;
+}
+
+void Logger::push(const char *text, size_t length)
+{
+    auto now = std::chrono::system_clock::now().time_since_epoch();
 
-    auto now = std::time(nullptr);
-    auto tm = *std::localtime(&now);
+    threadRing().push(std::chrono::duration_cast<std::chrono::milliseconds>(now).count(), text, length);
+}
+
+//=============================================================================
+// Writer thread
+//=============================================================================
+
+void Logger::startWriter()
+{
+    std::lock_guard<std::mutex> lock(rings_mutex);
+
+    if (!writer.joinable())
+        writer = std::thread(&Logger::writerLoop, this);
+}
 
-    std::cout << "[" << std::put_time(&tm, "%H:%M:%S") << "] " << direction << " packet: ";
+void Logger::writerLoop()
+{
+    std::vector<LogRing::Record> batch;
+
+    while (true) {
+        // Read before draining, what was logged before the stop still gets out
+        bool stop = stopping.load(std::memory_order_acquire);
+        size_t dropped = 0;
+
+        if (drain(batch, dropped) > 0 || dropped > 0)
+            write(batch, dropped);
+        else if (stop)
+            return;
+        else
+            std::this_thread::sleep_for(std::chrono::milliseconds(WRITER_POLL_MS));
+    }
+}
+
+size_t Logger::drain(std::vector<LogRing::Record> &batch, size_t &dropped)
+{
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    LogRing::Record record;
+
+    batch.clear();
+
+    for (auto it = rings.begin(); it != rings.end();) {
+        LogRing &ring = **it;
+        // Checked first: once retired, nothing more is pushed
+        bool retired = ring.isRetired();
+
+        // One ring's worth per pass, a chatty thread cannot starve the others
+        for (size_t i = 0; i < LogRing::CAPACITY && ring.pop(record); i++)
+            batch.push_back(record);
+
+        dropped += ring.takeDropped();
+
+        if (retired && ring.empty())
+            it = rings.erase(it);
+        else
+            it++;
+    }
+    return batch.size();
+}
+
+static void formatTime(time_t seconds, char (&stamp)[16])
+{
+    struct tm local;
+
+    localtime_r(&seconds, &local);
+    strftime(stamp, sizeof(stamp), "[%H:%M:%S] ", &local);
+}
+
+void Logger::write(std::vector<LogRing::Record> &batch, size_t dropped)
+{
+    std::string out;
+    time_t stamp_second = -1;
+    char stamp[16] = "";
+
+    // Every ring is in order already, this interleaves the threads
+    std::stable_sort(batch.begin(), batch.end(), [](const LogRing::Record &a, const LogRing::Record &b) {
+        return a.time_ms < b.time_ms;
+    });
+
+    for (const LogRing::Record &record : batch) {
+        time_t second = record.time_ms / 1000;
+
+        if (second != stamp_second) {
+            formatTime(second, stamp);
+            stamp_second = second;
+        }
+
+        out += stamp;
+        out.append(record.text, record.length);
+        out += '\n';
+    }
 
-    for (size_t i = 0; i < std::min(size, static_cast<size_t>(16)); i++) {
-        std::cout << std::hex << std::setw(2) << std::setfill('0')
-                  << (static_cast<int>(data[i]) & 0xFF) << " ";
+    if (dropped > 0) {
+        formatTime(std::time(nullptr), stamp);
+        out += stamp;
+        out += std::to_string(dropped) + " log messages dropped, the log writer could not keep up\n";
     }
 
-    if (size > 16) std::cout << "...";
-    std::cout << std::dec << std::endl;
+    std::cout << out << std::flush;
 }
 
 Logger g_logger;
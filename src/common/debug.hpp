@@ -13,25 +13,64 @@
 #include <ctime>
 #include <iomanip>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "log_ring.hpp"
 
+// Debug logging that stays out of the way. The macros test debug mode
+// before evaluating their arguments, so a disabled DEBUG_LOG costs one
+// relaxed load and never builds its message. An enabled one is copied
+// into the ring of the calling thread, a background writer merges the
+// rings in time order and writes them to stdout in batches: no lock,
+// no syscall and no formatting of the time on the logging thread.
+// There is one Logger per process, g_logger.
 class Logger {
     private:
-        bool debug_mode;
-        std::mutex log_mutex;
+        static constexpr int WRITER_POLL_MS = 10;
+
+        std::atomic<bool> debug_mode;
+
+        // Every thread that logged, guards the writer's start too
+        std::mutex rings_mutex;
+        std::vector<std::shared_ptr<LogRing>> rings;
+
+        std::thread writer;
+        std::atomic<bool> stopping;
+
+        LogRing &threadRing();
+
+        void push(const char *text, size_t length);
+
+        void startWriter();
+
+        void writerLoop();
+
+        size_t drain(std::vector<LogRing::Record> &batch, size_t &dropped);
+
+        void write(std::vector<LogRing::Record> &batch, size_t dropped);
 
     public:
         Logger(bool debug = false);
+        ~Logger();
+
+        Logger(const Logger &) = delete;
+        Logger &operator=(const Logger &) = delete;
 
         void setDebugMode(bool mode);
-        bool isDebugMode() const;
+        bool isDebugMode() const { return debug_mode.load(std::memory_order_relaxed); }
         void log(const std::string &msg);
-        void logPacket(const std::string& direction, const char *data, size_t size);
+        void logPacket(const char *direction, const char *data, size_t size);
 };
 
 extern Logger g_logger;
 
-#define DEBUG_LOG(msg) g_logger.log(msg)
-#define DEBUG_PACKET_SEND(data, size) g_logger.logPacket("SEND", data, size)
-#define DEBUG_PACKET_RECV(data, size) g_logger.logPacket("RECV", data, size)
+#define DEBUG_LOG(msg) \
+    do { if (g_logger.isDebugMode()) g_logger.log(msg); } while (0)
+#define DEBUG_PACKET_SEND(data, size) \
+    do { if (g_logger.isDebugMode()) g_logger.logPacket("SEND", data, size); } while (0)
+#define DEBUG_PACKET_RECV(data, size) \
+    do { if (g_logger.isDebugMode()) g_logger.logPacket("RECV", data, size); } while (0)
 
 #endif
@@ -0,0 +1,54 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "frame_reader.hpp"
+#include "debug.hpp"
+
+FrameReader::FrameReader(size_t capacity, uint32_t max_payload)
+    : buffer(capacity), max_payload(max_payload), state(READ_HEADER),
+      pending_header(), pending_size(0)
+{}
+
+FrameReader::Result FrameReader::next(Frame &frame)
+{
+    if (state == READ_HEADER) {
+        if (buffer.size() < sizeof(MessageHeader))
+            return NEED_MORE_DATA;
+
+        buffer.peek(&pending_header, sizeof(MessageHeader));
+        pending_size = Protocol::getPayloadSize(pending_header);
+
+        if (pending_size > max_payload) {
+            DEBUG_LOG("Frame too large: type=" + std::to_string(pending_header.type) +
+                      ", size=" + std::to_string(pending_size));
+            return FRAME_TOO_LARGE;
+        }
+
+        buffer.consume(sizeof(MessageHeader));
+        buffer.reserve(pending_size);
+        state = READ_PAYLOAD;
+    }
+
+    if (buffer.size() < pending_size)
+        return NEED_MORE_DATA;
+
+    const uint8_t *payload = buffer.contiguous(pending_size);
+
+    if (!payload) {
+        scratch.resize(pending_size);
+        buffer.peek(scratch.data(), pending_size);
+        payload = scratch.data();
+    }
+
+    frame.header = pending_header;
+    frame.payload = payload;
+    frame.size = pending_size;
+
+    buffer.consume(pending_size);
+    state = READ_HEADER;
+    return FRAME_READY;
+}
@@ -0,0 +1,62 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef FRAME_READER_HPP
+    #define FRAME_READER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "protocol.hpp"
+#include "ring_buffer.hpp"
+
+// Reassembles the byte stream of one connection into protocol messages.
+// Partial headers and payloads stay buffered across reads.
+class FrameReader {
+public:
+    struct Frame {
+        MessageHeader header;
+        const uint8_t *payload;
+        uint32_t size;
+    };
+
+    enum Result {
+        FRAME_READY,
+        NEED_MORE_DATA,
+        FRAME_TOO_LARGE
+    };
+
+private:
+    enum State {
+        READ_HEADER,
+        READ_PAYLOAD
+    };
+
+    RingBuffer buffer;
+    uint32_t max_payload;
+
+    State state;
+    MessageHeader pending_header;
+    uint32_t pending_size;
+
+    // Only used when a payload wraps around the end of the ring
+    std::vector<uint8_t> scratch;
+
+public:
+    FrameReader(size_t capacity, uint32_t max_payload);
+
+    ssize_t readFrom(int fd) { return buffer.readFrom(fd); }
+
+    void append(const void *data, size_t len) { buffer.write(data, len); }
+
+    // The returned payload pointer is valid until the next readFrom/append
+    Result next(Frame &frame);
+
+    bool isFull() const { return buffer.freeSpace() == 0; }
+    size_t buffered() const { return buffer.size(); }
+};
+
+#endif
@@ -0,0 +1,59 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "log_ring.hpp"
+#include <algorithm>
+#include <cstring>
+
+static_assert((LogRing::CAPACITY & (LogRing::CAPACITY - 1)) == 0, "LogRing::CAPACITY must be a power of two");
+
+LogRing::LogRing()
+    : records(std::make_unique<Record[]>(CAPACITY)), head(0), tail(0), dropped(0), retired(false)
+{}
+
+bool LogRing::push(int64_t time_ms, const char *text, size_t length)
+{
+    size_t position = tail.load(std::memory_order_relaxed);
+
+    if (position - head.load(std::memory_order_acquire) == CAPACITY) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Record &record = records[position & (CAPACITY - 1)];
+
+    record.time_ms = time_ms;
+    record.length = std::min(length, MAX_MESSAGE);
+    memcpy(record.text, text, record.length);
+
+    // Publishes the record, the consumer acquires tail before reading it
+    tail.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogRing::pop(Record &record)
+{
+    size_t position = head.load(std::memory_order_relaxed);
+
+    if (position == tail.load(std::memory_order_acquire))
+        return false;
+
+    const Record &slot = records[position & (CAPACITY - 1)];
+
+    record.time_ms = slot.time_ms;
+    record.length = slot.length;
+    memcpy(record.text, slot.text, slot.length);
+
+    // Hands the slot back to the producer
+    head.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogRing::empty() const
+{
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+}
@@ -0,0 +1,58 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef LOG_RING_HPP
+    #define LOG_RING_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+// Log messages of one thread on their way to the log writer. One producer
+// (the thread that owns the ring) and one consumer (the writer thread), no
+// lock: tail is only written by the producer, head by the consumer, both
+// only ever grow and the slot is index & (CAPACITY - 1).
+// A full ring never blocks the producer, the message is counted as dropped.
+class LogRing {
+public:
+    static const size_t CAPACITY = 512;
+    static constexpr size_t MAX_MESSAGE = 240; // longer messages are cut
+
+    struct Record {
+        int64_t time_ms; // system clock, when the message was logged
+        uint32_t length;
+        char text[MAX_MESSAGE];
+    };
+
+private:
+    std::unique_ptr<Record[]> records;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    std::atomic<size_t> dropped;
+    std::atomic<bool> retired;
+
+public:
+    LogRing();
+
+    // Producer side
+    bool push(int64_t time_ms, const char *text, size_t length);
+
+    // Consumer side, copies the oldest record out and frees its slot
+    bool pop(Record &record);
+
+    // Consumer side, messages dropped since the last call
+    size_t takeDropped() { return dropped.exchange(0, std::memory_order_relaxed); }
+
+    // The owning thread exited, the ring goes away once drained
+    void retire() { retired.store(true, std::memory_order_release); }
+    bool isRetired() const { return retired.load(std::memory_order_acquire); }
+
+    bool empty() const;
+};
+
+#endif
@@ -7,67 +7,285 @@
 
 #include "map.hpp"
 #include "debug.hpp"
-#include <fstream>
+#include "tile_scan.hpp"
+#include "smap.hpp"
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-Map::Map() : width(0), height(0)
-{}
+Map::Map() : tiles(nullptr), width(0), height(0), stride(1), columns(0),
+    coin_starts(nullptr), coin_rows(nullptr), hazard_starts(nullptr), hazard_rows(nullptr),
+    mask_words(1), masks{nullptr, nullptr}
+{
+    allocate(0, 0);
+}
 
-bool Map::loadFromFile(const std::string& filename)
+void Map::allocate(size_t w, size_t h)
 {
-    std::ifstream file(filename);
+    // One more column for the sentinel, rounded up to whole blocks
+    columns = (w + BLOCK_COLUMNS) / BLOCK_COLUMNS * BLOCK_COLUMNS;
 
-    if (!file.is_open())
-        return false;
+    width = w;
+    height = h;
+    stride = h + 1;
+    file_mapping.reset();
+    tile_storage.assign(columns * stride, '_');
+    tiles = tile_storage.data();
+
+    index_storage.clear();
+    coin_starts = coin_rows = hazard_starts = hazard_rows = nullptr;
 
-    mapData.clear();
-    std::string line;
+    mask_storage.clear();
+    mask_words = std::max<size_t>(1, (h + MASK_BITS - 1) / MASK_BITS);
+    masks[COIN_MASK] = masks[HAZARD_MASK] = nullptr;
+}
+
+void Map::buildIndex()
+{
+    std::vector<uint32_t> index(2 * (width + 1), 0);
+    std::vector<uint32_t> coins;
+    std::vector<uint32_t> hazards;
 
-    while (std::getline(file, line)) {
-        if (!line.empty()) {
-            mapData.push_back(line);
+    uint32_t *coin_counts = index.data();
+    uint32_t *hazard_counts = index.data() + width + 1;
+
+    for (size_t x = 0; x < width; x++) {
+        std::span<const char> column = getColumn(x);
+
+        coin_counts[x] = coins.size();
+        hazard_counts[x] = hazards.size();
+
+        for (size_t y = 0; y < height; y++) {
+            if (column[y] == 'c')
+                coins.push_back(y);
+            else if (column[y] == 'e')
+                hazards.push_back(y);
         }
     }
+    coin_counts[width] = coins.size();
+    hazard_counts[width] = hazards.size();
+
+    index.insert(index.end(), coins.begin(), coins.end());
+    index.insert(index.end(), hazards.begin(), hazards.end());
+
+    // Built aside and swapped in whole: the map is only read from other
+    // threads once its loaded columns are published, after this returns
+    index_storage.swap(index);
+    attachIndex(index_storage.data());
+    buildMasks();
+}
+
+void Map::buildMasks()
+{
+    size_t column_words = (width + 1) * mask_words;
+    std::vector<uint64_t> storage(2 * column_words, 0);
+
+    for (size_t x = 0; x < width; x++) {
+        uint64_t *coin_column = storage.data() + x * mask_words;
+        uint64_t *hazard_column = coin_column + column_words;
 
-    if (mapData.empty()) {
-        DEBUG_LOG("Error: Map file is empty");
+        for (uint32_t y : getCoins(x))
+            coin_column[y / MASK_BITS] |= 1ull << (y % MASK_BITS);
+        for (uint32_t y : getHazards(x))
+            hazard_column[y / MASK_BITS] |= 1ull << (y % MASK_BITS);
+    }
+
+    mask_storage.swap(storage);
+    masks[COIN_MASK] = mask_storage.data();
+    masks[HAZARD_MASK] = mask_storage.data() + column_words;
+}
+
+bool Map::getCoinIndex(size_t x, size_t y, uint32_t &index) const
+{
+    if (!masks[COIN_MASK] || x >= width || y >= height)
+        return false;
+
+    const uint64_t *column = masks[COIN_MASK] + x * mask_words;
+    size_t word = y / MASK_BITS;
+    uint64_t bit = 1ull << (y % MASK_BITS);
+
+    if (!(column[word] & bit))
+        return false;
+
+    size_t rank = __builtin_popcountll(column[word] & (bit - 1));
+
+    for (size_t i = 0; i < word; i++)
+        rank += __builtin_popcountll(column[i]);
+
+    index = coin_starts[x] + rank;
+    return true;
+}
+
+bool Map::findFirst(MaskKind kind, size_t x, size_t from, size_t to, size_t &row) const
+{
+    size_t lo = std::min(from, to);
+    size_t hi = std::min(std::max(from, to), height - 1);
+
+    if (!masks[kind] || height == 0 || lo > hi)
         return false;
+
+    const uint64_t *column = masks[kind] + std::min(x, width) * mask_words;
+
+    // Going down the first row is the lowest set bit, going up the highest
+    if (from <= to) {
+        for (size_t word = lo / MASK_BITS; word <= hi / MASK_BITS; word++) {
+            uint64_t bits = column[word] & rangeBits(word, lo, hi);
+
+            if (bits) {
+                row = word * MASK_BITS + __builtin_ctzll(bits);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    for (size_t word = hi / MASK_BITS + 1; word-- > lo / MASK_BITS; ) {
+        uint64_t bits = column[word] & rangeBits(word, lo, hi);
+
+        if (bits) {
+            row = word * MASK_BITS + (MASK_BITS - 1 - __builtin_clzll(bits));
+            return true;
+        }
+    }
+    return false;
+}
+
+void Map::attachIndex(const uint32_t *index)
+{
+    coin_starts = index;
+    hazard_starts = index + width + 1;
+    coin_rows = index + 2 * (width + 1);
+    hazard_rows = coin_rows + coin_starts[width];
+}
+
+bool Map::fail(const std::string &message)
+{
+    last_error = message;
+    DEBUG_LOG("Error: " + message);
+    return false;
+}
+
+bool Map::loadFromFile(const std::string& filename)
+{
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+        return fail("cannot open " + filename);
+
+    struct stat info;
+
+    if (fstat(fd, &info) < 0 || info.st_size == 0) {
+        close(fd);
+        return fail("Map file is empty");
+    }
+
+    size_t size = info.st_size;
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+        return fail("cannot map " + filename);
+
+    // A .smap file keeps being used in place, the mapping lives with the map
+    if (SmapHeader::hasMagic(static_cast<const uint8_t *>(mapping), size)) {
+        std::shared_ptr<const uint8_t> shared(static_cast<const uint8_t *>(mapping),
+            [size](const uint8_t *data) { munmap(const_cast<uint8_t *>(data), size); });
+
+        return loadFromSmap(std::move(shared), size);
     }
 
-    height = mapData.size();
-    width = mapData[0].length();
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    bool loaded = loadFromText(static_cast<const char *>(mapping), size);
 
-    for (const auto& line : mapData) {
-        if (line.length() != width) {
-            DEBUG_LOG("Inconsistent line lengths");
-            return false;
+    munmap(mapping, size);
+    return loaded;
+}
+
+bool Map::loadFromText(const char *text, size_t size)
+{
+    std::vector<size_t> line_starts;
+    size_t w = 0;
+    size_t line_number = 0;
+    size_t pos = 0;
+
+    // One vector scan per line: the first non-tile byte has to be its '\n'
+    while (pos < size) {
+        size_t length = TileScan::findNonTile(text + pos, size - pos);
+
+        line_number++;
+
+        if (pos + length < size && text[pos + length] != '\n') {
+            return fail("invalid tile '" + std::string(1, text[pos + length]) + "' at line " +
+                        std::to_string(line_number) + ", column " + std::to_string(length + 1));
         }
 
-        for (char c : line) {
-            if (c != '_' && c != 'c' && c != 'e')
-                return false;
+        // Empty lines are skipped, like the old getline loader did
+        if (length > 0) {
+            if (line_starts.empty())
+                w = length;
+            else if (length != w)
+                return fail("Inconsistent line lengths at line " + std::to_string(line_number) +
+                            ": " + std::to_string(length) + " tiles, expected " + std::to_string(w));
+            line_starts.push_back(pos);
         }
+
+        pos += length + 1;
     }
+
+    if (line_starts.empty())
+        return fail("Map file is empty");
+
+    allocate(w, line_starts.size());
+
+    // Row-major text into column-major storage, in 16x16 squares. A band
+    // of BLOCK_COLUMNS rows is done at once so every cache line written in
+    // a column gets filled entirely. The ragged edges go one by one.
+    const size_t square = TileScan::TRANSPOSE_SIZE;
+    const char *rows[BLOCK_COLUMNS];
+    size_t full_height = height - height % square;
+    size_t full_width = width - width % square;
+
+    for (size_t band = 0; band < full_height; band += BLOCK_COLUMNS) {
+        size_t band_rows = std::min(BLOCK_COLUMNS, full_height - band);
+
+        for (size_t i = 0; i < band_rows; i++)
+            rows[i] = text + line_starts[band + i];
+
+        for (size_t x0 = 0; x0 < full_width; x0 += square) {
+            for (size_t i = 0; i < band_rows; i += square)
+                TileScan::transpose(rows + i, x0, &tileAt(x0, band + i), stride);
+        }
+    }
+
+    for (size_t y = 0; y < height; y++) {
+        const char *row = text + line_starts[y];
+        size_t x = (y < full_height) ? full_width : 0;
+
+        for (; x < width; x++)
+            tileAt(x, y) = row[x];
+    }
+
+    buildIndex();
+    last_error.clear();
     return true;
 }
 
 std::vector<uint8_t> Map::serialize() const
 {
-    std::vector<uint8_t> data;
-
-    data.push_back((width >> 24) & 0xFF);
-    data.push_back((width >> 16) & 0xFF);
-    data.push_back((width >> 8) & 0xFF);
-    data.push_back(width & 0xFF);
+    std::vector<uint8_t> data(MapDataHeaderSchema::SIZE);
 
-    data.push_back((height >> 24) & 0xFF);
-    data.push_back((height >> 16) & 0xFF);
-    data.push_back((height >> 8) & 0xFF);
-    data.push_back(height & 0xFF);
+    MapDataHeaderSchema::encode({ static_cast<uint32_t>(width), static_cast<uint32_t>(height) }, data.data());
 
-    for (const auto& line : mapData) {
-        for (char c : line) {
-            data.push_back(static_cast<uint8_t>(c));
+    // The wire format stays row-major
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            data.push_back(static_cast<uint8_t>(getTile(x, y)));
         }
     }
 
@@ -75,49 +293,142 @@ std::vector<uint8_t> Map::serialize() const
     return data;
 }
 
+size_t Map::getChunkColumns() const
+{
+    size_t columns = height > 0 ? CHUNK_BYTES / height : CHUNK_BYTES;
+
+    // Sent on 2 bytes, and a column never gets split
+    return std::max<size_t>(1, std::min<size_t>(columns, 0xFFFF));
+}
+
+size_t Map::getChunkCount() const
+{
+    size_t columns = getChunkColumns();
+
+    return (width + columns - 1) / columns;
+}
+
+std::vector<uint8_t> Map::serializeInfo() const
+{
+    std::vector<uint8_t> data(INFO_SIZE);
+    MapInfoMessage info = {
+        static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+        static_cast<uint16_t>(getChunkColumns()), static_cast<uint32_t>(getChunkCount())
+    };
+
+    MapInfoSchema::encode(info, data.data());
+    return data;
+}
+
+std::vector<uint8_t> Map::serializeChunk(size_t index) const
+{
+    std::vector<uint8_t> data;
+    size_t columns = getChunkColumns();
+    size_t first = index * columns;
+
+    if (first >= width)
+        return data;
+
+    size_t count = std::min(columns, width - first);
+
+    data.reserve(CHUNK_HEADER_SIZE + count * height);
+    data.resize(CHUNK_HEADER_SIZE);
+    MapChunkHeaderSchema::encode({ static_cast<uint32_t>(index), static_cast<uint32_t>(first),
+                                   static_cast<uint16_t>(count) }, data.data());
+
+    // Column-major like the storage: the client can draw a column as soon
+    // as it has it
+    for (size_t x = first; x < first + count; x++) {
+        std::span<const char> column = getColumn(x);
+
+        data.insert(data.end(), column.begin(), column.end());
+    }
+    return data;
+}
+
+bool Map::loadInfo(const uint8_t *data, size_t size)
+{
+    MapInfoMessage info;
+
+    if (!MapInfoSchema::decode(data, size, info)) {
+        DEBUG_LOG("Error: Map info too short");
+        return false;
+    }
+
+    allocate(info.width, info.height);
+
+    DEBUG_LOG("Receiving map: " + std::to_string(width) + "x" + std::to_string(height) +
+              " in " + std::to_string(info.chunk_count) + " chunks");
+    return true;
+}
+
+bool Map::loadChunk(const uint8_t *data, size_t size, size_t &end_column)
+{
+    MapChunkHeader header;
+
+    if (!MapChunkHeaderSchema::decode(data, size, header))
+        return false;
+
+    size_t first = header.first_column;
+    size_t count = header.column_count;
+
+    if (first > width || count > width - first || size != CHUNK_HEADER_SIZE + count * height) {
+        DEBUG_LOG("Error: Map chunk " + std::to_string(header.index) + " does not fit the map");
+        return false;
+    }
+
+    const uint8_t *chunk_tiles = data + CHUNK_HEADER_SIZE;
+
+    for (size_t x = first; x < first + count; x++) {
+        memcpy(&tileAt(x, 0), chunk_tiles, height);
+        chunk_tiles += height;
+    }
+
+    end_column = first + count;
+
+    if (end_column == width)
+        buildIndex();
+    return true;
+}
+
 bool Map::loadFromData(const std::vector<uint8_t>& data)
 {
-    if (data.size() < 8) {
+    MapDataHeader header;
+
+    if (!MapDataHeaderSchema::decode(data.data(), data.size(), header)) {
         DEBUG_LOG("Error: Insufficient data to deserialize map");
         return false;
     }
 
-    size_t w = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
-    size_t h = (data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
+    size_t w = header.width;
+    size_t h = header.height;
 
-    if (data.size() != 8 + (w * h)) {
+    if (data.size() != MapDataHeaderSchema::SIZE + (w * h)) {
         DEBUG_LOG("Error: Map data size mismatch");
         return false;
     }
 
-    mapData.clear();
-    width = w;
-    height = h;
+    allocate(w, h);
 
     for (size_t y = 0; y < h; y++) {
-        std::string line;
         for (size_t x = 0; x < w; x++) {
-            size_t idx = 8 + y * w + x;
-            line.push_back(static_cast<char>(data[idx]));
+            size_t idx = MapDataHeaderSchema::SIZE + y * w + x;
+            tileAt(x, y) = static_cast<char>(data[idx]);
         }
-        mapData.push_back(line);
     }
 
+    buildIndex();
     DEBUG_LOG("Deserialized map: " + std::to_string(width) + "x" + std::to_string(height));
     return true;
 }
 
-char Map::getTile(size_t x, size_t y) const
-{
-    if (y >= mapData.size() || x >= mapData[y].length())
-        return '_';
-
-    return mapData[y][x];
-}
-
 void Map::printMap() const
 {
-    for (const auto& line : mapData) {
+    for (size_t y = 0; y < height; y++) {
+        std::string line;
+
+        for (size_t x = 0; x < width; x++)
+            line.push_back(getTile(x, y));
         std::cout << line << std::endl;
     }
 }
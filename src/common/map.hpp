@@ -11,26 +11,199 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <span>
+#include "messages.hpp"
 
+// Tiles are stored column-major in one flat array, since both the server
+// (players scrolling along x) and the renderer walk the map column by
+// column. Columns come in blocks of BLOCK_COLUMNS and every column has a
+// sentinel row at y == height, column width is a sentinel column: reads
+// outside the map clamp onto '_' tiles instead of branching.
+//
+// Next to the tiles, a per-column index lists the rows of the coins and
+// hazards, and per-column bitmasks (bit y set when row y holds one) answer
+// "what is between these two rows" with a few bit operations. A map loaded
+// from a .smap file (see smap.hpp) uses all of them straight from the
+// mapped file.
 class Map {
+public:
+    enum MaskKind {
+        COIN_MASK,
+        HAZARD_MASK
+    };
+
+    static constexpr size_t MASK_BITS = 64;
+
+    // Target payload of one MSG_MAP_CHUNK, whole columns only
+    static const size_t CHUNK_BYTES = 16384;
+    static const size_t INFO_SIZE = MapInfoSchema::SIZE;
+    static const size_t CHUNK_HEADER_SIZE = MapChunkHeaderSchema::SIZE;
+
+    static constexpr size_t BLOCK_COLUMNS = 64;
+
 private:
-    std::vector<std::string> mapData;
+    // Owned storage, unused when the map comes from a mapped .smap file
+    std::vector<char> tile_storage;
+    std::vector<uint32_t> index_storage;
+    std::shared_ptr<const uint8_t> file_mapping;
+
+    const char *tiles;
     size_t width;
     size_t height;
+    size_t stride;      // height + the sentinel row
+    size_t columns;     // allocated columns, sentinel and padding included
+
+    // Index: coin_starts[x] is the number of coins before column x, the
+    // rows of those in column x are coin_rows[coin_starts[x]..coin_starts[x + 1]].
+    // Same for hazards. Null until the whole map is loaded.
+    const uint32_t *coin_starts;
+    const uint32_t *coin_rows;
+    const uint32_t *hazard_starts;
+    const uint32_t *hazard_rows;
+
+    // Masks: mask_words words per column, width + 1 columns (the last one
+    // is an empty sentinel), coin masks then hazard masks. Null until the
+    // whole map is loaded.
+    std::vector<uint64_t> mask_storage;
+    size_t mask_words;
+    const uint64_t *masks[2];
+
+    std::string last_error;
+
+    bool fail(const std::string &message);
+
+    // Sized for w x h (plus sentinels), every tile set to '_'
+    void allocate(size_t w, size_t h);
+
+    char &tileAt(size_t x, size_t y) { return tile_storage[x * stride + y]; }
+
+    // Builds the row index and the masks from the tiles
+    void buildIndex();
+
+    void buildMasks();
+
+    // Points the index at index_storage (or a mapped file), laid out as
+    // coin_starts, hazard_starts, coin_rows, hazard_rows
+    void attachIndex(const uint32_t *index);
+
+    bool loadFromSmap(std::shared_ptr<const uint8_t> mapping, size_t size);
 
 public:
     Map();
 
+    Map(const Map &) = delete;
+    Map &operator=(const Map &) = delete;
+
+    // Text maps are validated with TileScan, .smap files (recognised by
+    // their magic) are checked and mapped as is. See getLastError() on failure.
     bool loadFromFile(const std::string& filename);
 
+    bool loadFromText(const char *text, size_t size);
+
     bool loadFromData(const std::vector<uint8_t>& data);
 
     std::vector<uint8_t> serialize() const;
 
-    char getTile(size_t x, size_t y) const;
+    // Chunked transfer (MSG_MAP_INFO + MSG_MAP_CHUNK), see doc.txt
+    size_t getChunkColumns() const;
+    size_t getChunkCount() const;
+    std::vector<uint8_t> serializeInfo() const;
+    std::vector<uint8_t> serializeChunk(size_t index) const;
+
+    // loadInfo sizes an empty map, chunks then fill it column by column.
+    // end_column is set to the column after the last one written.
+    bool loadInfo(const uint8_t *data, size_t size);
+    bool loadChunk(const uint8_t *data, size_t size, size_t &end_column);
+
+    // Any x/y is fine, outside the map is '_' (negative ints wrap and clamp too)
+    char getTile(size_t x, size_t y) const
+    {
+        return tiles[std::min(x, width) * stride + std::min(y, height)];
+    }
+
+    // The height tiles of column x, top to bottom. Past the end of the map
+    // it is the empty sentinel column.
+    std::span<const char> getColumn(size_t x) const
+    {
+        return std::span<const char>(tiles + std::min(x, width) * stride, height);
+    }
+
     size_t getWidth() const { return width; }
     size_t getHeight() const { return height; }
 
+    // Rows of the coins (hazards) in column x, empty outside the map
+    std::span<const uint32_t> getCoins(size_t x) const
+    {
+        if (!coin_starts || x >= width)
+            return {};
+        return std::span<const uint32_t>(coin_rows + coin_starts[x],
+                                         coin_starts[x + 1] - coin_starts[x]);
+    }
+
+    std::span<const uint32_t> getHazards(size_t x) const
+    {
+        if (!hazard_starts || x >= width)
+            return {};
+        return std::span<const uint32_t>(hazard_rows + hazard_starts[x],
+                                         hazard_starts[x + 1] - hazard_starts[x]);
+    }
+
+    // Coins are numbered column by column, top to bottom
+    size_t getFirstCoin(size_t x) const { return coin_starts ? coin_starts[std::min(x, width)] : 0; }
+    size_t getCoinCount() const { return coin_starts ? coin_starts[width] : 0; }
+    size_t getHazardCount() const { return hazard_starts ? hazard_starts[width] : 0; }
+
+    // Number of the coin at (x, y), false when there is none. Counts the
+    // coin bits above y in the column masks.
+    bool getCoinIndex(size_t x, size_t y, uint32_t &index) const;
+
+    // Rows from..to of column x (either order, clamped to the map) as a
+    // sweep. findFirst returns the first set row met going from "from" to
+    // "to", forEach calls fn(row) for every set row, top to bottom.
+    bool findFirst(MaskKind kind, size_t x, size_t from, size_t to, size_t &row) const;
+
+    template <typename Fn>
+    void forEach(MaskKind kind, size_t x, size_t from, size_t to, Fn &&fn) const
+    {
+        size_t lo = std::min(from, to);
+        size_t hi = std::min(std::max(from, to), height - 1);
+
+        if (!masks[kind] || height == 0 || lo > hi)
+            return;
+
+        const uint64_t *column = masks[kind] + std::min(x, width) * mask_words;
+
+        for (size_t word = lo / MASK_BITS; word <= hi / MASK_BITS; word++) {
+            uint64_t bits = column[word] & rangeBits(word, lo, hi);
+
+            while (bits) {
+                fn(word * MASK_BITS + __builtin_ctzll(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // Bits of word (of a column mask) that fall in rows lo..hi
+    static uint64_t rangeBits(size_t word, size_t lo, size_t hi)
+    {
+        size_t first = word * MASK_BITS;
+        uint64_t low = lo > first ? ~0ull << (lo - first) : ~0ull;
+        uint64_t high = hi < first + MASK_BITS - 1 ? ~0ull >> (first + MASK_BITS - 1 - hi) : ~0ull;
+
+        return low & high;
+    }
+
+    // Writes the map as a .smap file, see smap.hpp
+    bool saveAsSmap(const std::string &filename) const;
+
+    // Recomputes the checksum of a map loaded from a .smap file
+    bool verifySmapChecksum() const;
+
+    // Why the last load failed, with the line and column of the bad byte
+    const std::string &getLastError() const { return last_error; }
+
     void printMap() const;
 };
 
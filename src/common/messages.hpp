@@ -0,0 +1,313 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef MESSAGES_HPP
+    #define MESSAGES_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include "protocol.hpp"
+
+//=============================================================================
+// Wire schemas
+//
+// Every fixed-size message (or fixed-size part of one) is declared once
+// below as a struct and the list of its members in wire order. Encoders
+// and decoders are generated from that list: each field sits at an offset
+// known at compile time, big-endian, and the only runtime check is one
+// size check for the whole message. The static_asserts pin every layout
+// to doc.txt byte for byte, server and client share these definitions.
+//=============================================================================
+
+template <typename T>
+struct WireField;
+
+template <>
+struct WireField<uint8_t> {
+    static constexpr size_t SIZE = 1;
+
+    static constexpr void store(uint8_t *out, uint8_t value) { out[0] = value; }
+    static constexpr uint8_t load(const uint8_t *in) { return in[0]; }
+};
+
+template <>
+struct WireField<bool> {
+    static constexpr size_t SIZE = 1;
+
+    static constexpr void store(uint8_t *out, bool value) { out[0] = value ? 1 : 0; }
+    static constexpr bool load(const uint8_t *in) { return in[0] != 0; }
+};
+
+template <>
+struct WireField<uint16_t> {
+    static constexpr size_t SIZE = 2;
+
+    static constexpr void store(uint8_t *out, uint16_t value)
+    {
+        out[0] = value >> 8;
+        out[1] = value & 0xFF;
+    }
+
+    static constexpr uint16_t load(const uint8_t *in)
+    {
+        return static_cast<uint16_t>((in[0] << 8) | in[1]);
+    }
+};
+
+template <>
+struct WireField<uint32_t> {
+    static constexpr size_t SIZE = 4;
+
+    static constexpr void store(uint8_t *out, uint32_t value)
+    {
+        out[0] = value >> 24;
+        out[1] = (value >> 16) & 0xFF;
+        out[2] = (value >> 8) & 0xFF;
+        out[3] = value & 0xFF;
+    }
+
+    static constexpr uint32_t load(const uint8_t *in)
+    {
+        return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+               (static_cast<uint32_t>(in[2]) << 8) | in[3];
+    }
+};
+
+// Codec of the member a pointer to member designates
+template <typename Message, auto Member>
+using WireFieldOf = WireField<std::remove_cvref_t<decltype(std::declval<const Message &>().*Member)>>;
+
+template <typename MessageStruct, auto... Members>
+struct WireSchema {
+    using Message = MessageStruct;
+
+    static constexpr size_t SIZE = (WireFieldOf<Message, Members>::SIZE + ... + 0);
+
+    static constexpr void encode(const Message &message, uint8_t *out)
+    {
+        size_t offset = 0;
+
+        ((WireFieldOf<Message, Members>::store(out + offset, message.*Members),
+          offset += WireFieldOf<Message, Members>::SIZE), ...);
+    }
+
+    // The caller guarantees SIZE readable bytes
+    static constexpr Message decode(const uint8_t *in)
+    {
+        Message message{};
+        size_t offset = 0;
+
+        ((message.*Members = WireFieldOf<Message, Members>::load(in + offset),
+          offset += WireFieldOf<Message, Members>::SIZE), ...);
+        return message;
+    }
+
+    // False, message untouched, when fewer than SIZE bytes are there
+    static constexpr bool decode(const uint8_t *in, size_t size, Message &message)
+    {
+        if (size < SIZE)
+            return false;
+        message = decode(in);
+        return true;
+    }
+};
+
+// A schema that is the whole payload of one message type
+template <MessageType Type, typename Schema>
+struct MessageSchema : Schema {
+    using typename Schema::Message;
+
+    static constexpr MessageType TYPE = Type;
+    static constexpr size_t PACKET_SIZE = sizeof(MessageHeader) + Schema::SIZE;
+
+    static_assert(Schema::SIZE <= Protocol::MAX_PAYLOAD_SIZE, "Payload too large for the 3-byte size field");
+
+    // Header and payload at the start of buffer, returns the packet size
+    // or 0 when the buffer is too small
+    static constexpr size_t writePacket(std::span<uint8_t> buffer, const Message &message)
+    {
+        if (buffer.size() < PACKET_SIZE)
+            return 0;
+
+        buffer[0] = TYPE;
+        buffer[1] = (Schema::SIZE >> 16) & 0xFF;
+        buffer[2] = (Schema::SIZE >> 8) & 0xFF;
+        buffer[3] = Schema::SIZE & 0xFF;
+        Schema::encode(message, buffer.data() + sizeof(MessageHeader));
+        return PACKET_SIZE;
+    }
+
+    static constexpr std::array<uint8_t, PACKET_SIZE> packet(const Message &message)
+    {
+        std::array<uint8_t, PACKET_SIZE> bytes{};
+
+        writePacket(bytes, message);
+        return bytes;
+    }
+};
+
+//=============================================================================
+// Messages
+//=============================================================================
+
+// MSG_CONNECT, an empty payload means no capabilities
+struct ConnectMessage {
+    uint8_t capabilities;
+};
+
+using ConnectSchema = MessageSchema<MSG_CONNECT, WireSchema<ConnectMessage, &ConnectMessage::capabilities>>;
+
+// MSG_GAME_START, older servers sent an empty payload
+struct GameStartMessage {
+    uint8_t player_number;
+};
+
+using GameStartSchema = MessageSchema<MSG_GAME_START,
+    WireSchema<GameStartMessage, &GameStartMessage::player_number>>;
+
+struct PlayerInputMessage {
+    bool jet_active;
+};
+
+using PlayerInputSchema = MessageSchema<MSG_PLAYER_INPUT,
+    WireSchema<PlayerInputMessage, &PlayerInputMessage::jet_active>>;
+
+// One player of a snapshot, also one record of MSG_GAME_STATE (the payload
+// is as many records as there are players)
+struct PlayerSnapshot {
+    uint8_t player_number;
+    uint16_t x;
+    uint16_t y;
+    uint16_t score;
+    bool jet_active;
+};
+
+using StateRecordSchema = WireSchema<PlayerSnapshot, &PlayerSnapshot::player_number, &PlayerSnapshot::x,
+    &PlayerSnapshot::y, &PlayerSnapshot::score, &PlayerSnapshot::jet_active>;
+
+// MSG_COLLISION, type is 'c' or 'e'. Older servers stopped after the
+// position, the legacy schema is what they sent.
+struct CollisionMessage {
+    uint8_t type;
+    uint16_t x;
+    uint16_t y;
+    uint8_t player_number;
+};
+
+using CollisionSchema = MessageSchema<MSG_COLLISION, WireSchema<CollisionMessage, &CollisionMessage::type,
+    &CollisionMessage::x, &CollisionMessage::y, &CollisionMessage::player_number>>;
+using LegacyCollisionSchema = MessageSchema<MSG_COLLISION, WireSchema<CollisionMessage, &CollisionMessage::type,
+    &CollisionMessage::x, &CollisionMessage::y>>;
+
+// MSG_GAME_END, 0xFF when nobody won
+struct GameEndMessage {
+    uint8_t winner;
+};
+
+using GameEndSchema = MessageSchema<MSG_GAME_END, WireSchema<GameEndMessage, &GameEndMessage::winner>>;
+
+struct CountdownMessage {
+    uint8_t value;
+};
+
+using CountdownSchema = MessageSchema<MSG_COUNTDOWN, WireSchema<CountdownMessage, &CountdownMessage::value>>;
+
+struct StateAckMessage {
+    uint32_t sequence;
+};
+
+using StateAckSchema = MessageSchema<MSG_STATE_ACK, WireSchema<StateAckMessage, &StateAckMessage::sequence>>;
+
+struct UdpOfferMessage {
+    uint16_t port;
+    uint32_t token;
+};
+
+using UdpOfferSchema = MessageSchema<MSG_UDP_OFFER,
+    WireSchema<UdpOfferMessage, &UdpOfferMessage::port, &UdpOfferMessage::token>>;
+
+// Start of MSG_MAP_DATA, the tiles follow
+struct MapDataHeader {
+    uint32_t width;
+    uint32_t height;
+};
+
+using MapDataHeaderSchema = WireSchema<MapDataHeader, &MapDataHeader::width, &MapDataHeader::height>;
+
+struct MapInfoMessage {
+    uint32_t width;
+    uint32_t height;
+    uint16_t chunk_columns;
+    uint32_t chunk_count;
+};
+
+using MapInfoSchema = MessageSchema<MSG_MAP_INFO, WireSchema<MapInfoMessage, &MapInfoMessage::width,
+    &MapInfoMessage::height, &MapInfoMessage::chunk_columns, &MapInfoMessage::chunk_count>>;
+
+// Start of MSG_MAP_CHUNK, the columns follow
+struct MapChunkHeader {
+    uint32_t index;
+    uint32_t first_column;
+    uint16_t column_count;
+};
+
+using MapChunkHeaderSchema = WireSchema<MapChunkHeader, &MapChunkHeader::index,
+    &MapChunkHeader::first_column, &MapChunkHeader::column_count>;
+
+// Before the messages of a datagram sent to the UDP port of the server
+struct UdpClientPrefix {
+    uint32_t token;
+    uint32_t sequence;
+};
+
+using UdpClientPrefixSchema = WireSchema<UdpClientPrefix, &UdpClientPrefix::token, &UdpClientPrefix::sequence>;
+
+// Before the packet of a datagram sent by the server
+struct UdpServerPrefix {
+    uint32_t sequence;
+};
+
+using UdpServerPrefixSchema = WireSchema<UdpServerPrefix, &UdpServerPrefix::sequence>;
+
+//=============================================================================
+// doc.txt, byte for byte
+//=============================================================================
+
+static_assert(sizeof(MessageHeader) == 4);
+
+static_assert(ConnectSchema::packet({ CAP_DELTA_STATE | CAP_UDP }) ==
+              std::array<uint8_t, 5>{ MSG_CONNECT, 0, 0, 1, 0x03 });
+static_assert(GameStartSchema::packet({ 1 }) == std::array<uint8_t, 5>{ MSG_GAME_START, 0, 0, 1, 1 });
+static_assert(PlayerInputSchema::packet({ true }) == std::array<uint8_t, 5>{ MSG_PLAYER_INPUT, 0, 0, 1, 1 });
+static_assert(GameEndSchema::packet({ 0xFF }) == std::array<uint8_t, 5>{ MSG_GAME_END, 0, 0, 1, 0xFF });
+static_assert(CountdownSchema::packet({ 3 }) == std::array<uint8_t, 5>{ MSG_COUNTDOWN, 0, 0, 1, 3 });
+
+static_assert(StateRecordSchema::SIZE == 8, "MSG_GAME_STATE records are 8 bytes");
+static_assert(StateRecordSchema::decode(std::array<uint8_t, 8>{ 2, 0x01, 0x02, 0, 7, 0x30, 0x39, 1 }.data()).score == 12345);
+
+static_assert(CollisionSchema::packet({ 'c', 0x0102, 0x0304, 5 }) ==
+              std::array<uint8_t, 10>{ MSG_COLLISION, 0, 0, 6, 'c', 0x01, 0x02, 0x03, 0x04, 5 });
+static_assert(LegacyCollisionSchema::SIZE == 5, "Older servers sent 5-byte collisions");
+
+static_assert(StateAckSchema::packet({ 0x01020304 }) ==
+              std::array<uint8_t, 8>{ MSG_STATE_ACK, 0, 0, 4, 0x01, 0x02, 0x03, 0x04 });
+static_assert(UdpOfferSchema::packet({ 4243, 0xDEADBEEF }) ==
+              std::array<uint8_t, 10>{ MSG_UDP_OFFER, 0, 0, 6, 0x10, 0x93, 0xDE, 0xAD, 0xBE, 0xEF });
+
+static_assert(MapDataHeaderSchema::SIZE == 8);
+static_assert(MapInfoSchema::packet({ 1000, 20, 819, 2 }) ==
+              std::array<uint8_t, 18>{ MSG_MAP_INFO, 0, 0, 14, 0, 0, 0x03, 0xE8, 0, 0, 0, 20, 0x03, 0x33, 0, 0, 0, 2 });
+static_assert(MapChunkHeaderSchema::SIZE == 10);
+
+static_assert(UdpClientPrefixSchema::SIZE == 8);
+static_assert(UdpServerPrefixSchema::SIZE == 4);
+
+#endif
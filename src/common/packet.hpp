@@ -0,0 +1,41 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef PACKET_HPP
+    #define PACKET_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Encoded packet (header + payload) that is never modified once built.
+// Copies only bump a reference count, so a broadcast encodes once and
+// every recipient's send queue holds a pointer to the same bytes.
+// A packet can also be a slice of a bigger shared buffer (see MapCache).
+class SharedPacket {
+private:
+    std::shared_ptr<const std::vector<uint8_t>> bytes;
+    size_t offset = 0;
+    size_t length = 0;
+
+public:
+    SharedPacket() = default;
+
+    explicit SharedPacket(std::vector<uint8_t> &&encoded)
+        : bytes(std::make_shared<const std::vector<uint8_t>>(std::move(encoded))),
+          length(bytes->size()) {}
+
+    SharedPacket(std::shared_ptr<const std::vector<uint8_t>> buffer, size_t offset, size_t length)
+        : bytes(std::move(buffer)), offset(offset), length(length) {}
+
+    const uint8_t *data() const { return bytes ? bytes->data() + offset : nullptr; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+};
+
+#endif
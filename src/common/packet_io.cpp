@@ -0,0 +1,190 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "packet_io.hpp"
+#include <cstring>
+
+//=============================================================================
+// PacketWriter
+//=============================================================================
+
+PacketWriter::PacketWriter(std::span<uint8_t> buffer)
+    : buffer(buffer), position(0), has_header(false), overflow(false)
+{}
+
+PacketWriter::PacketWriter(std::span<uint8_t> buffer, MessageType type)
+    : buffer(buffer), position(0), has_header(true), overflow(false)
+{
+    uint8_t *header = reserve(sizeof(MessageHeader));
+
+    if (header)
+        header[0] = type;
+}
+
+uint8_t *PacketWriter::reserve(size_t size)
+{
+    if (overflow || size > buffer.size() - position) {
+        overflow = true;
+        return nullptr;
+    }
+
+    uint8_t *field = buffer.data() + position;
+
+    position += size;
+    return field;
+}
+
+void PacketWriter::u8(uint8_t value)
+{
+    uint8_t *field = reserve(1);
+
+    if (field)
+        field[0] = value;
+}
+
+void PacketWriter::u16(uint16_t value)
+{
+    uint8_t *field = reserve(2);
+
+    if (!field)
+        return;
+    field[0] = value >> 8;
+    field[1] = value & 0xFF;
+}
+
+void PacketWriter::u32(uint32_t value)
+{
+    uint8_t *field = reserve(4);
+
+    if (!field)
+        return;
+    field[0] = value >> 24;
+    field[1] = (value >> 16) & 0xFF;
+    field[2] = (value >> 8) & 0xFF;
+    field[3] = value & 0xFF;
+}
+
+void PacketWriter::bytes(const uint8_t *data, size_t size)
+{
+    uint8_t *field = reserve(size);
+
+    if (field && size > 0)
+        memcpy(field, data, size);
+}
+
+size_t PacketWriter::finish()
+{
+    if (overflow)
+        return 0;
+
+    if (!has_header)
+        return position;
+
+    size_t payload_size = position - sizeof(MessageHeader);
+
+    if (payload_size > Protocol::MAX_PAYLOAD_SIZE)
+        return 0;
+
+    buffer[1] = (payload_size >> 16) & 0xFF;
+    buffer[2] = (payload_size >> 8) & 0xFF;
+    buffer[3] = payload_size & 0xFF;
+    return position;
+}
+
+//=============================================================================
+// PacketReader
+//=============================================================================
+
+PacketReader::PacketReader(const uint8_t *data, size_t size)
+    : data(data), length(data ? size : 0), position(0), overflow(false)
+{}
+
+PacketReader::PacketReader(const char *data, size_t size)
+    : PacketReader(reinterpret_cast<const uint8_t *>(data), size)
+{}
+
+const uint8_t *PacketReader::take(size_t size)
+{
+    if (overflow || size > length - position) {
+        overflow = true;
+        return nullptr;
+    }
+
+    const uint8_t *field = data + position;
+
+    position += size;
+    return field;
+}
+
+uint8_t PacketReader::u8()
+{
+    const uint8_t *field = take(1);
+
+    return field ? field[0] : 0;
+}
+
+uint16_t PacketReader::u16()
+{
+    const uint8_t *field = take(2);
+
+    return field ? static_cast<uint16_t>((field[0] << 8) | field[1]) : 0;
+}
+
+uint32_t PacketReader::u32()
+{
+    const uint8_t *field = take(4);
+
+    if (!field)
+        return 0;
+    return (static_cast<uint32_t>(field[0]) << 24) | (static_cast<uint32_t>(field[1]) << 16) |
+           (static_cast<uint32_t>(field[2]) << 8) | field[3];
+}
+
+const uint8_t *PacketReader::bytes(size_t size)
+{
+    return take(size);
+}
+
+//=============================================================================
+// PacketPool
+//=============================================================================
+
+PacketPool::PacketPool() : current(0)
+{}
+
+std::span<uint8_t> PacketPool::acquire(size_t size)
+{
+    size_t count = buffers.size();
+    size_t found = count;
+
+    // Round robin from the last one: the buffers of older ticks are the
+    // ones most likely to be flushed already
+    for (size_t i = 1; i <= count && found == count; i++) {
+        size_t index = (current + i) % count;
+
+        if (buffers[index].use_count() == 1)
+            found = index;
+    }
+
+    if (found == count)
+        buffers.push_back(std::make_shared<std::vector<uint8_t>>());
+
+    current = found;
+
+    std::vector<uint8_t> &buffer = *buffers[current];
+
+    if (buffer.size() < size)
+        buffer.resize(size);
+    return std::span<uint8_t>(buffer.data(), buffer.size());
+}
+
+SharedPacket PacketPool::share(size_t size)
+{
+    if (size == 0 || current >= buffers.size())
+        return SharedPacket();
+    return SharedPacket(buffers[current], 0, size);
+}
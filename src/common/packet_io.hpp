@@ -0,0 +1,132 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef PACKET_IO_HPP
+    #define PACKET_IO_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+#include "protocol.hpp"
+#include "packet.hpp"
+
+// Big-endian fields written straight into a buffer the caller owns, nothing
+// is ever allocated. With a message type the 4-byte header is reserved
+// first and finish() fills in the payload size, without one the writer
+// only appends fields (a datagram prefix for instance).
+// Writing past the end of the buffer sets a sticky overflow flag instead
+// of writing, finish() then returns 0.
+class PacketWriter {
+private:
+    std::span<uint8_t> buffer;
+    size_t position;
+    bool has_header;
+    bool overflow;
+
+    uint8_t *reserve(size_t size);
+
+public:
+    explicit PacketWriter(std::span<uint8_t> buffer);
+    PacketWriter(std::span<uint8_t> buffer, MessageType type);
+
+    void u8(uint8_t value);
+    void u16(uint16_t value);
+    void u32(uint32_t value);
+    void bytes(const uint8_t *data, size_t size);
+
+    // A fixed-size schema from messages.hpp, one bounds check for all of it
+    template <typename Schema>
+    void write(const typename Schema::Message &message)
+    {
+        uint8_t *field = reserve(Schema::SIZE);
+
+        if (field)
+            Schema::encode(message, field);
+    }
+
+    // Bytes written so far, header included
+    size_t size() const { return position; }
+    bool ok() const { return !overflow; }
+
+    // Patches the payload size, returns the bytes to send or 0 if the
+    // fields did not fit in the buffer or in the 3-byte size field
+    size_t finish();
+};
+
+// Reads big-endian fields from a payload without ever reading past its
+// end: a field that is not there reads as 0 and clears ok() for good, so
+// a handler can read everything it needs and check once.
+class PacketReader {
+private:
+    const uint8_t *data;
+    size_t length;
+    size_t position;
+    bool overflow;
+
+    const uint8_t *take(size_t size);
+
+public:
+    PacketReader(const uint8_t *data, size_t size);
+    PacketReader(const char *data, size_t size);
+
+    uint8_t u8();
+    uint16_t u16();
+    uint32_t u32();
+
+    // The next size bytes, or nullptr when there are not that many left
+    const uint8_t *bytes(size_t size);
+
+    // A fixed-size schema from messages.hpp, false if it is not all there
+    template <typename Schema>
+    bool read(typename Schema::Message &message)
+    {
+        const uint8_t *field = take(Schema::SIZE);
+
+        if (!field)
+            return false;
+        message = Schema::decode(field);
+        return true;
+    }
+
+    size_t remaining() const { return length - position; }
+    size_t offset() const { return position; }
+    bool ok() const { return !overflow; }
+};
+
+// Buffers for the packets a room sends every tick. A buffer is reused once
+// no SharedPacket refers to it any more (every send queue is done with it)
+// and it keeps its capacity, so a warmed up pool never allocates.
+// Only one buffer is being written at a time: acquire() it, write the
+// packet, share() it.
+class PacketPool {
+private:
+    std::vector<std::shared_ptr<std::vector<uint8_t>>> buffers;
+    size_t current;
+
+public:
+    PacketPool();
+
+    // A buffer of at least size bytes that no packet uses
+    std::span<uint8_t> acquire(size_t size);
+
+    // The first size bytes of the last acquired buffer, as a packet.
+    // A size of 0 (a failed PacketWriter) gives an empty packet.
+    SharedPacket share(size_t size);
+
+    // A whole fixed-size message (a MessageSchema from messages.hpp)
+    template <typename Schema>
+    SharedPacket make(const typename Schema::Message &message)
+    {
+        return share(Schema::writePacket(acquire(Schema::PACKET_SIZE), message));
+    }
+
+    size_t getBufferCount() const { return buffers.size(); }
+};
+
+#endif
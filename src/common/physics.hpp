@@ -0,0 +1,59 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef PHYSICS_HPP
+    #define PHYSICS_HPP
+
+#include <cstdint>
+#include <algorithm>
+
+// Nearest Q16.16 value of numerator / denominator, at compile time
+constexpr int32_t fixedRatio(int64_t numerator, int64_t denominator)
+{
+    int64_t scaled = numerator * (int64_t(1) << 16) * 2 / denominator;
+
+    return static_cast<int32_t>(scaled >= 0 ? (scaled + 1) / 2 : (scaled - 1) / 2);
+}
+
+// Vertical movement in Q16.16 fixed point: 16 bits of tile, 16 bits of
+// fraction. Only integer additions, shifts and clamps, so a replay or a
+// client predicting its own player ends up on the exact same positions as
+// the server, whatever the compiler or the CPU.
+struct Physics {
+    using Fixed = int32_t;
+
+    static constexpr int FRACTION_BITS = 16;
+    static constexpr Fixed ONE = Fixed(1) << FRACTION_BITS;
+
+    // Constants a modif si mal equilibré, juste faut mettre en commentaires les anciennes valeurs au cas ou
+    // (tiles per tick, per tick)
+    static constexpr Fixed GRAVITY = fixedRatio(1, 2);
+    static constexpr Fixed JET_POWER = fixedRatio(-4, 5);
+    static constexpr Fixed MAX_VELOCITY = fixedRatio(2, 1);
+
+    // Highest row a Fixed position can hold with room for one more step
+    static constexpr int MAX_ROW = (INT32_MAX - MAX_VELOCITY) >> FRACTION_BITS;
+
+    static constexpr Fixed fromTile(int tile) { return static_cast<Fixed>(tile) * ONE; }
+
+    // Rounds down, positions are never negative
+    static constexpr int toTile(Fixed value) { return value >> FRACTION_BITS; }
+
+    // One tick of vertical movement, y stays in rows 0..max_row
+    static constexpr void step(Fixed &y, Fixed &velocity, bool jet_active, int max_row)
+    {
+        velocity += jet_active ? JET_POWER : GRAVITY;
+        velocity = std::max(-MAX_VELOCITY, std::min(velocity, MAX_VELOCITY));
+        y = std::max(Fixed(0), std::min(y + velocity, fromTile(std::min(max_row, MAX_ROW))));
+    }
+};
+
+static_assert(Physics::GRAVITY == 32768);
+static_assert(Physics::JET_POWER == -52429);
+static_assert(Physics::MAX_VELOCITY == 2 * Physics::ONE);
+
+#endif
@@ -7,21 +7,18 @@
 
 #include "protocol.hpp"
 #include "debug.hpp"
+#include "packet_io.hpp"
 #include <cstring>
 
 std::vector<uint8_t> Protocol::createPacket(MessageType type, const std::vector<uint8_t> &payload)
 {
-    MessageHeader header;
-    header.type = type;
-    setPayloadSize(header, payload.size());
-
     std::vector<uint8_t> packet(sizeof(MessageHeader) + payload.size());
+    PacketWriter writer(packet, type);
 
-    memcpy(packet.data(), &header, sizeof(MessageHeader));
+    writer.bytes(payload.data(), payload.size());
 
-    if (!payload.empty()) {
-        memcpy(packet.data() + sizeof(MessageHeader), payload.data(), payload.size());
-    }
+    // Empty when the payload does not fit in the 3-byte size field
+    packet.resize(writer.finish());
 
     DEBUG_LOG("Created packet: Type=" + std::to_string(type) +
               ", Size=" + std::to_string(payload.size()));
@@ -29,6 +26,11 @@ std::vector<uint8_t> Protocol::createPacket(MessageType type, const std::vector<
     return packet;
 }
 
+SharedPacket Protocol::createSharedPacket(MessageType type, const std::vector<uint8_t> &payload)
+{
+    return SharedPacket(createPacket(type, payload));
+}
+
 bool Protocol::parseHeader(const char *data, size_t size, MessageHeader &header)
 {
     if (size < sizeof(MessageHeader)) {
@@ -53,9 +55,9 @@ uint32_t Protocol::getPayloadSize(const MessageHeader &header)
 
 void Protocol::setPayloadSize(MessageHeader &header, uint32_t size)
 {
-    if (size > 0xFFFFFF) { // Faut pas depasser 3 bytes sinn kaboom
+    if (size > MAX_PAYLOAD_SIZE) { // Faut pas depasser 3 bytes sinn kaboom
         DEBUG_LOG("Warning: Payload size too large, truncating");
-        size = 0xFFFFFF;
+        size = MAX_PAYLOAD_SIZE;
     }
 
     header.payload_size[0] = (size >> 16) & 0xFF;
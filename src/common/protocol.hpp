@@ -11,6 +11,7 @@
 #include <cstdint>
 #include <string>
 #include <vector>
+#include "packet.hpp"
 
 enum MessageType : uint8_t {
     MSG_CONNECT = 1,      // Client connecting
@@ -20,7 +21,22 @@ enum MessageType : uint8_t {
     MSG_GAME_STATE = 5,   // positions, scores, etc.
     MSG_COLLISION = 6,    // collision
     MSG_GAME_END = 7,      // game is over
-    MSG_COUNTDOWN = 8     // countdown before game starts
+    MSG_COUNTDOWN = 8,    // countdown before game starts
+    MSG_GAME_STATE_DELTA = 9, // game state encoded against an acked snapshot
+    MSG_STATE_ACK = 10,   // client acknowledges a delta snapshot
+    MSG_UDP_OFFER = 11,   // UDP port and token for the snapshot channel
+    MSG_UDP_HELLO = 12,   // first datagram of a client, proves the token
+    MSG_UDP_READY = 13,   // server got the hello, snapshots now go over UDP
+    MSG_MAP_INFO = 14,    // map dimensions, announces the chunks that follow
+    MSG_MAP_CHUNK = 15,   // a run of map columns
+    MSG_COIN_SYNC = 16    // coins a player collected (empty payload: request)
+};
+
+// Optional MSG_CONNECT payload byte, what the client can handle
+enum ClientCapability : uint8_t {
+    CAP_DELTA_STATE = 1 << 0,
+    CAP_UDP = 1 << 1,
+    CAP_MAP_CHUNKS = 1 << 2
 };
 
 struct MessageHeader {
@@ -30,7 +46,10 @@ struct MessageHeader {
 
 class Protocol {
 public:
+    static const uint32_t MAX_PAYLOAD_SIZE = 0xFFFFFF; // 3 byte size field
+
     static std::vector<uint8_t> createPacket(MessageType type, const std::vector<uint8_t> &payload);
+    static SharedPacket createSharedPacket(MessageType type, const std::vector<uint8_t> &payload);
     static bool parseHeader(const char *data, size_t size, MessageHeader &header);
     static uint32_t getPayloadSize(const MessageHeader &header);
     static void setPayloadSize(MessageHeader &header, uint32_t size);
@@ -0,0 +1,107 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "ring_buffer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <sys/uio.h>
+
+static size_t roundUpPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+RingBuffer::RingBuffer(size_t capacity)
+    : storage(roundUpPowerOfTwo(std::max<size_t>(capacity, 16))),
+      mask(storage.size() - 1), head(0), tail(0)
+{}
+
+void RingBuffer::reserve(size_t min_capacity)
+{
+    if (min_capacity <= storage.size())
+        return;
+
+    std::vector<uint8_t> grown(roundUpPowerOfTwo(min_capacity));
+    size_t used = size();
+
+    peek(grown.data(), used);
+    storage.swap(grown);
+    mask = storage.size() - 1;
+    head = 0;
+    tail = used;
+}
+
+ssize_t RingBuffer::readFrom(int fd)
+{
+    size_t free_bytes = freeSpace();
+
+    if (free_bytes == 0) {
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    size_t start = tail & mask;
+    size_t first = std::min(free_bytes, storage.size() - start);
+
+    struct iovec iov[2];
+    iov[0].iov_base = storage.data() + start;
+    iov[0].iov_len = first;
+    iov[1].iov_base = storage.data();
+    iov[1].iov_len = free_bytes - first;
+
+    ssize_t bytes_read = readv(fd, iov, iov[1].iov_len > 0 ? 2 : 1);
+
+    if (bytes_read > 0)
+        tail += bytes_read;
+    return bytes_read;
+}
+
+void RingBuffer::write(const void *src, size_t len)
+{
+    reserve(size() + len);
+
+    const uint8_t *bytes = static_cast<const uint8_t *>(src);
+    size_t start = tail & mask;
+    size_t first = std::min(len, storage.size() - start);
+
+    memcpy(storage.data() + start, bytes, first);
+    memcpy(storage.data(), bytes + first, len - first);
+    tail += len;
+}
+
+void RingBuffer::peek(void *dst, size_t len, size_t offset) const
+{
+    uint8_t *out = static_cast<uint8_t *>(dst);
+    size_t start = (head + offset) & mask;
+    size_t first = std::min(len, storage.size() - start);
+
+    memcpy(out, storage.data() + start, first);
+    memcpy(out + first, storage.data(), len - first);
+}
+
+const uint8_t *RingBuffer::contiguous(size_t len, size_t offset) const
+{
+    size_t start = (head + offset) & mask;
+
+    if (start + len > storage.size())
+        return nullptr;
+    return storage.data() + start;
+}
+
+void RingBuffer::consume(size_t len)
+{
+    head += std::min(len, size());
+
+    // Rewind when empty so the next burst lands in one contiguous block
+    if (head == tail)
+        head = tail = 0;
+}
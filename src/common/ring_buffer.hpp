@@ -0,0 +1,53 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef RING_BUFFER_HPP
+    #define RING_BUFFER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <sys/types.h>
+
+// Byte ring with a power-of-two capacity. head/tail only ever grow, the
+// position in storage is index & mask, so size() is just tail - head.
+class RingBuffer {
+private:
+    std::vector<uint8_t> storage;
+    size_t mask;
+    size_t head;
+    size_t tail;
+
+public:
+    explicit RingBuffer(size_t capacity);
+
+    size_t size() const { return tail - head; }
+    size_t capacity() const { return storage.size(); }
+    size_t freeSpace() const { return storage.size() - size(); }
+    bool empty() const { return head == tail; }
+
+    // Grows the ring (never shrinks), keeps the buffered bytes
+    void reserve(size_t min_capacity);
+
+    // One readv() into the free space, both halves of the wrap at once.
+    // Same return convention as recv().
+    ssize_t readFrom(int fd);
+
+    void write(const void *src, size_t len);
+
+    void peek(void *dst, size_t len, size_t offset = 0) const;
+
+    // Pointer to len buffered bytes starting at offset, or nullptr if
+    // that range wraps around the end of the storage
+    const uint8_t *contiguous(size_t len, size_t offset = 0) const;
+
+    void consume(size_t len);
+
+    void clear() { head = tail = 0; }
+};
+
+#endif
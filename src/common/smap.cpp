@@ -0,0 +1,306 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "smap.hpp"
+#include "map.hpp"
+#include "debug.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+//=============================================================================
+// Header
+//=============================================================================
+
+static void putLittle(uint8_t *out, uint64_t value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; i++)
+        out[i] = (value >> (8 * i)) & 0xFF;
+}
+
+static uint64_t getLittle(const uint8_t *data, size_t bytes)
+{
+    uint64_t value = 0;
+
+    for (size_t i = 0; i < bytes; i++)
+        value |= static_cast<uint64_t>(data[i]) << (8 * i);
+    return value;
+}
+
+void SmapHeader::encode(uint8_t *out) const
+{
+    memset(out, 0, SIZE);
+    putLittle(out, MAGIC, 4);
+    putLittle(out + 4, version, 2);
+    putLittle(out + 6, SIZE, 2);
+    putLittle(out + 8, width, 4);
+    putLittle(out + 12, height, 4);
+    putLittle(out + 16, stride, 4);
+    putLittle(out + 20, columns, 4);
+    putLittle(out + 24, tiles_offset, 8);
+    putLittle(out + 32, tiles_size, 8);
+    putLittle(out + 40, index_offset, 8);
+    putLittle(out + 48, index_size, 8);
+    putLittle(out + 56, checksum, 8);
+    putLittle(out + 64, masks_offset, 8);
+    putLittle(out + 72, masks_size, 8);
+}
+
+bool SmapHeader::hasMagic(const uint8_t *data, size_t size)
+{
+    return size >= 4 && getLittle(data, 4) == MAGIC;
+}
+
+bool SmapHeader::decode(const uint8_t *data, size_t size)
+{
+    if (size < SIZE || !hasMagic(data, size))
+        return false;
+
+    version = getLittle(data + 4, 2);
+    if (version != VERSION || getLittle(data + 6, 2) != SIZE)
+        return false;
+
+    width = getLittle(data + 8, 4);
+    height = getLittle(data + 12, 4);
+    stride = getLittle(data + 16, 4);
+    columns = getLittle(data + 20, 4);
+    tiles_offset = getLittle(data + 24, 8);
+    tiles_size = getLittle(data + 32, 8);
+    index_offset = getLittle(data + 40, 8);
+    index_size = getLittle(data + 48, 8);
+    checksum = getLittle(data + 56, 8);
+    masks_offset = getLittle(data + 64, 8);
+    masks_size = getLittle(data + 72, 8);
+    return true;
+}
+
+uint64_t SmapHeader::checksumBytes(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+//=============================================================================
+// Validation
+//=============================================================================
+
+// Checksum of the three parts of a .smap file, as map_compile computes it
+static uint64_t smapChecksum(const char *tiles, size_t tiles_size, const uint32_t *index, size_t index_size,
+                             const uint64_t *masks, size_t masks_size)
+{
+    uint64_t checksum = SmapHeader::checksumBytes(SmapHeader::CHECKSUM_SEED, tiles, tiles_size);
+
+    checksum = SmapHeader::checksumBytes(checksum, index, index_size);
+    return SmapHeader::checksumBytes(checksum, masks, masks_size);
+}
+
+// starts[x] counts the rows listed before column x: it begins at 0, never
+// goes down and ends at count. bad_column is set on failure.
+static bool checkStarts(const uint32_t *starts, size_t width, size_t count, size_t &bad_column)
+{
+    for (size_t x = 0; x <= width; x++) {
+        bad_column = x;
+        if ((x == 0 && starts[x] != 0) || (x > 0 && starts[x] < starts[x - 1]) || starts[x] > count)
+            return false;
+    }
+    return true;
+}
+
+// The rows listed for column x are exactly its tiles of that kind, top to
+// bottom. Needs checkStarts() first.
+static bool checkRows(const SmapHeader &header, const char *tiles, const uint32_t *starts,
+                      const uint32_t *rows, char tile, size_t &bad_column)
+{
+    for (size_t x = 0; x < header.width; x++) {
+        const char *column = tiles + x * header.stride;
+        uint32_t next = starts[x];
+
+        bad_column = x;
+        for (uint32_t y = 0; y < header.height; y++) {
+            if (column[y] != tile)
+                continue;
+            if (next == starts[x + 1] || rows[next] != y)
+                return false;
+            next++;
+        }
+        if (next != starts[x + 1])
+            return false;
+    }
+    return true;
+}
+
+// The mask of column x has the bits of its listed rows and nothing else,
+// the sentinel column is empty. Needs checkRows() first.
+static bool checkMasks(const uint64_t *masks, size_t words, size_t width, const uint32_t *starts,
+                       const uint32_t *rows, size_t &bad_column)
+{
+    std::vector<uint64_t> expected(words);
+
+    for (size_t x = 0; x <= width; x++) {
+        std::fill(expected.begin(), expected.end(), 0);
+        if (x < width) {
+            for (uint32_t i = starts[x]; i < starts[x + 1]; i++)
+                expected[rows[i] / Map::MASK_BITS] |= 1ull << (rows[i] % Map::MASK_BITS);
+        }
+
+        bad_column = x;
+        if (!std::equal(expected.begin(), expected.end(), masks + x * words))
+            return false;
+    }
+    return true;
+}
+
+//=============================================================================
+// Map loading and saving
+//=============================================================================
+
+bool Map::loadFromSmap(std::shared_ptr<const uint8_t> mapping, size_t size)
+{
+    SmapHeader header;
+
+    if (std::endian::native != std::endian::little)
+        return fail(".smap files are little-endian, this host is not");
+
+    if (!header.decode(mapping.get(), size))
+        return fail("unsupported .smap version, run map_compile on the text map again");
+
+    // Sizes and offsets first, nothing is read before they are known to
+    // fit in the file
+    size_t index_words = 2 * (static_cast<size_t>(header.width) + 1);
+    size_t words = std::max<size_t>(1, (static_cast<size_t>(header.height) + MASK_BITS - 1) / MASK_BITS);
+    size_t column_words = (static_cast<size_t>(header.width) + 1) * words;
+
+    if (header.stride != static_cast<uint64_t>(header.height) + 1 ||
+        header.columns <= header.width || header.columns % BLOCK_COLUMNS != 0 ||
+        header.tiles_size != static_cast<uint64_t>(header.columns) * header.stride ||
+        header.tiles_offset % SmapHeader::TILES_ALIGNMENT != 0 ||
+        header.tiles_offset > size || header.tiles_size > size - header.tiles_offset ||
+        header.index_offset % sizeof(uint32_t) != 0 ||
+        header.index_offset > size || header.index_size > size - header.index_offset ||
+        header.index_size < index_words * sizeof(uint32_t) ||
+        header.masks_offset % sizeof(uint64_t) != 0 ||
+        header.masks_offset > size || header.masks_size > size - header.masks_offset ||
+        header.masks_size != 2 * column_words * sizeof(uint64_t))
+        return fail("corrupted .smap header");
+
+    const uint32_t *index = reinterpret_cast<const uint32_t *>(mapping.get() + header.index_offset);
+    size_t coin_count = index[header.width];
+    size_t hazard_count = index[2 * header.width + 1];
+
+    if (header.index_size != (index_words + coin_count + hazard_count) * sizeof(uint32_t))
+        return fail("corrupted .smap index");
+
+    // Then everything the map trusts: the collision code indexes the rows
+    // and the masks without bounds checks
+    const char *file_tiles = reinterpret_cast<const char *>(mapping.get() + header.tiles_offset);
+    const uint32_t *file_coin_starts = index;
+    const uint32_t *file_hazard_starts = index + header.width + 1;
+    const uint32_t *file_coin_rows = index + index_words;
+    const uint32_t *file_hazard_rows = file_coin_rows + coin_count;
+    const uint64_t *file_masks = reinterpret_cast<const uint64_t *>(mapping.get() + header.masks_offset);
+    size_t column;
+
+    if (smapChecksum(file_tiles, header.tiles_size, index, header.index_size, file_masks,
+                     header.masks_size) != header.checksum)
+        return fail("bad .smap checksum, run map_compile on the text map again");
+
+    if (!checkStarts(file_coin_starts, header.width, coin_count, column) ||
+        !checkRows(header, file_tiles, file_coin_starts, file_coin_rows, 'c', column))
+        return fail("corrupted .smap index: coins of column " + std::to_string(column) +
+                    " do not match the tiles");
+
+    if (!checkStarts(file_hazard_starts, header.width, hazard_count, column) ||
+        !checkRows(header, file_tiles, file_hazard_starts, file_hazard_rows, 'e', column))
+        return fail("corrupted .smap index: hazards of column " + std::to_string(column) +
+                    " do not match the tiles");
+
+    if (!checkMasks(file_masks, words, header.width, file_coin_starts, file_coin_rows, column))
+        return fail("corrupted .smap coin mask at column " + std::to_string(column));
+
+    if (!checkMasks(file_masks + column_words, words, header.width, file_hazard_starts, file_hazard_rows,
+                    column))
+        return fail("corrupted .smap hazard mask at column " + std::to_string(column));
+
+    tile_storage.clear();
+    tile_storage.shrink_to_fit();
+    index_storage.clear();
+    index_storage.shrink_to_fit();
+    mask_storage.clear();
+    mask_storage.shrink_to_fit();
+
+    width = header.width;
+    height = header.height;
+    stride = header.stride;
+    columns = header.columns;
+    tiles = file_tiles;
+    attachIndex(index);
+    mask_words = words;
+    masks[COIN_MASK] = file_masks;
+    masks[HAZARD_MASK] = file_masks + column_words;
+    file_mapping = std::move(mapping);
+
+    last_error.clear();
+    DEBUG_LOG("Mapped .smap: " + std::to_string(width) + "x" + std::to_string(height) + ", " +
+              std::to_string(coin_count) + " coins");
+    return true;
+}
+
+bool Map::saveAsSmap(const std::string &filename) const
+{
+    SmapHeader header;
+    size_t tiles_size = columns * stride;
+    size_t index_words = 2 * (width + 1) + getCoinCount() + getHazardCount();
+
+    if (std::endian::native != std::endian::little || !coin_starts || !masks[COIN_MASK])
+        return false;
+
+    header.version = SmapHeader::VERSION;
+    header.width = width;
+    header.height = height;
+    header.stride = stride;
+    header.columns = columns;
+    header.tiles_offset = SmapHeader::TILES_ALIGNMENT;
+    header.tiles_size = tiles_size;
+    header.index_offset = (header.tiles_offset + tiles_size + 63) / 64 * 64;
+    header.index_size = index_words * sizeof(uint32_t);
+    header.masks_offset = (header.index_offset + header.index_size + 7) / 8 * 8;
+    header.masks_size = 2 * (width + 1) * mask_words * sizeof(uint64_t);
+    header.checksum = smapChecksum(tiles, tiles_size, coin_starts, header.index_size, masks[COIN_MASK],
+                                   header.masks_size);
+
+    std::vector<uint8_t> header_bytes(header.tiles_offset, 0);
+    std::vector<uint8_t> padding(header.index_offset - header.tiles_offset - tiles_size, 0);
+    std::vector<uint8_t> mask_padding(header.masks_offset - header.index_offset - header.index_size, 0);
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+
+    header.encode(header_bytes.data());
+    file.write(reinterpret_cast<const char *>(header_bytes.data()), header_bytes.size());
+    file.write(tiles, tiles_size);
+    file.write(reinterpret_cast<const char *>(padding.data()), padding.size());
+    file.write(reinterpret_cast<const char *>(coin_starts), header.index_size);
+    file.write(reinterpret_cast<const char *>(mask_padding.data()), mask_padding.size());
+    file.write(reinterpret_cast<const char *>(masks[COIN_MASK]), header.masks_size);
+    return static_cast<bool>(file);
+}
+
+bool Map::verifySmapChecksum() const
+{
+    SmapHeader header;
+
+    if (!file_mapping || !header.decode(file_mapping.get(), SmapHeader::SIZE))
+        return false;
+
+    return smapChecksum(tiles, header.tiles_size, coin_starts, header.index_size, masks[COIN_MASK],
+                        header.masks_size) == header.checksum;
+}
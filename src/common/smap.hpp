@@ -0,0 +1,68 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef SMAP_HPP
+    #define SMAP_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+// Precompiled map (.smap), written by map_compile. All numbers are
+// little-endian. The tiles, the index and the collision masks are stored
+// exactly as Map keeps them in memory, so loading one is an mmap and one
+// read to check them: the checksum, then the index and the masks against
+// the tiles.
+//
+//   Header (80 bytes)
+//     Magic "SMAP" (4)
+//     Version (2), Header Size (2)
+//     Width (4), Height (4)
+//     Stride (4): height + 1 sentinel row
+//     Columns (4): width + 1 sentinel column, rounded up to 64
+//     Tiles Offset (8), Tiles Size (8): columns x stride bytes, column-major
+//     Index Offset (8), Index Size (8)
+//     Checksum (8): FNV-1a 64 of the tiles, the index then the masks
+//     Masks Offset (8), Masks Size (8)
+//   Tiles, at a page aligned offset
+//   Index (32-bit words): coin starts (width + 1), hazard starts (width + 1),
+//     coin rows, hazard rows. See Map for the meaning.
+//   Masks (64-bit words, 8 byte aligned): coin masks then hazard masks,
+//     (height + 63) / 64 words per column, width + 1 columns.
+//
+// Version 1 files had no masks, map_compile has to be run again on them.
+struct SmapHeader {
+    static const uint32_t MAGIC = 0x50414D53; // "SMAP" read as little-endian
+    static const uint16_t VERSION = 2;
+    static const size_t SIZE = 80;
+    static const size_t TILES_ALIGNMENT = 4096;
+
+    uint16_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t columns;
+    uint64_t tiles_offset;
+    uint64_t tiles_size;
+    uint64_t index_offset;
+    uint64_t index_size;
+    uint64_t checksum;
+    uint64_t masks_offset;
+    uint64_t masks_size;
+
+    void encode(uint8_t *out) const;
+
+    // False when the magic or the version does not match
+    bool decode(const uint8_t *data, size_t size);
+
+    static bool hasMagic(const uint8_t *data, size_t size);
+
+    static uint64_t checksumBytes(uint64_t hash, const void *data, size_t size);
+
+    static const uint64_t CHECKSUM_SEED = 0xCBF29CE484222325ull;
+};
+
+#endif
@@ -0,0 +1,300 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "snapshot.hpp"
+#include "varint.hpp"
+#include <algorithm>
+
+//=============================================================================
+// SnapshotHistory
+//=============================================================================
+
+void SnapshotHistory::store(const Snapshot &snapshot)
+{
+    Snapshot &slot = ring[snapshot.sequence % SIZE];
+
+    // assign() keeps the slot's capacity, no allocation once warmed up
+    slot.sequence = snapshot.sequence;
+    slot.players.assign(snapshot.players.begin(), snapshot.players.end());
+}
+
+const Snapshot *SnapshotHistory::find(uint32_t sequence) const
+{
+    if (sequence == 0)
+        return nullptr;
+
+    const Snapshot &slot = ring[sequence % SIZE];
+
+    return slot.sequence == sequence ? &slot : nullptr;
+}
+
+//=============================================================================
+// MSG_GAME_STATE records
+//=============================================================================
+
+void StateRecords::encode(const PlayerSnapshot &player, PacketWriter &writer)
+{
+    writer.write<StateRecordSchema>(player);
+}
+
+void StateRecords::decode(const uint8_t *data, size_t size, std::vector<PlayerSnapshot> &out)
+{
+    PacketReader reader(data, size);
+    PlayerSnapshot player;
+
+    out.clear();
+
+    while (reader.read<StateRecordSchema>(player))
+        out.push_back(player);
+}
+
+//=============================================================================
+// Encoding
+//=============================================================================
+
+// Walks both snapshots at once, they are sorted by player number: fn(base,
+// player) for every current player (base is null for a new one) and
+// fn(base, nullptr) for every baseline player that left, in order
+template <typename Fn>
+static void mergePlayers(const Snapshot *baseline, const Snapshot &current, Fn &&fn)
+{
+    const PlayerSnapshot *base = baseline ? baseline->players.data() : nullptr;
+    const PlayerSnapshot *base_end = baseline ? base + baseline->players.size() : nullptr;
+
+    for (const auto &player : current.players) {
+        while (base != base_end && base->player_number < player.player_number)
+            fn(base++, nullptr);
+
+        if (base != base_end && base->player_number == player.player_number)
+            fn(base++, &player);
+        else
+            fn(nullptr, &player);
+    }
+
+    while (base != base_end)
+        fn(base++, nullptr);
+}
+
+static uint8_t changeMask(const PlayerSnapshot &base, const PlayerSnapshot &player)
+{
+    uint8_t mask = player.jet_active ? SnapshotCodec::JET_ACTIVE : 0;
+
+    if (player.x != base.x)
+        mask |= SnapshotCodec::CHANGED_X;
+    if (player.y != base.y)
+        mask |= SnapshotCodec::CHANGED_Y;
+    if (player.score != base.score)
+        mask |= SnapshotCodec::CHANGED_SCORE;
+    return mask;
+}
+
+// What the decoder assumes a player looks like when it is not listed:
+// its baseline record moved forward by the shared x delta
+static PlayerSnapshot predict(const PlayerSnapshot *base, uint16_t common_dx)
+{
+    PlayerSnapshot predicted = base ? *base : PlayerSnapshot{};
+
+    if (base)
+        predicted.x += common_dx;
+    return predicted;
+}
+
+static bool hasChanged(const PlayerSnapshot *base, const PlayerSnapshot &predicted,
+                       const PlayerSnapshot &player)
+{
+    return !base || predicted.x != player.x || predicted.y != player.y ||
+           predicted.score != player.score || predicted.jet_active != player.jet_active;
+}
+
+void SnapshotCodec::encode(const Snapshot *baseline, const Snapshot &current, std::vector<uint8_t> &out)
+{
+    uint32_t changed = 0;
+    uint32_t removed = 0;
+    uint16_t common_dx = 0;
+    bool found_dx = false;
+
+    // Everybody runs forward at the same speed, so the x delta is sent once
+    // and players that only moved forward do not need a record at all
+    mergePlayers(baseline, current, [&](const PlayerSnapshot *base, const PlayerSnapshot *player) {
+        if (base && player && !found_dx) {
+            common_dx = player->x - base->x;
+            found_dx = true;
+        }
+    });
+
+    Varint::write(out, current.sequence);
+    Varint::write(out, baseline ? baseline->sequence : 0);
+    Varint::write(out, Varint::zigzagEncode(static_cast<int16_t>(common_dx)));
+
+    // Counted first, both counts are written before their lists
+    mergePlayers(baseline, current, [&](const PlayerSnapshot *base, const PlayerSnapshot *player) {
+        if (!player)
+            removed++;
+        else if (hasChanged(base, predict(base, common_dx), *player))
+            changed++;
+    });
+
+    Varint::write(out, changed);
+
+    mergePlayers(baseline, current, [&](const PlayerSnapshot *base, const PlayerSnapshot *player) {
+        if (!player)
+            return;
+
+        PlayerSnapshot from = predict(base, common_dx);
+
+        if (!hasChanged(base, from, *player))
+            return;
+
+        uint8_t mask = changeMask(from, *player);
+
+        out.push_back(player->player_number);
+        out.push_back(mask);
+
+        if (mask & CHANGED_X)
+            Varint::write(out, Varint::zigzagEncode(static_cast<int16_t>(player->x - from.x)));
+        if (mask & CHANGED_Y)
+            Varint::write(out, Varint::zigzagEncode(static_cast<int16_t>(player->y - from.y)));
+        if (mask & CHANGED_SCORE)
+            Varint::write(out, Varint::zigzagEncode(static_cast<int16_t>(player->score - from.score)));
+    });
+
+    Varint::write(out, removed);
+
+    if (removed > 0) {
+        mergePlayers(baseline, current, [&](const PlayerSnapshot *base, const PlayerSnapshot *player) {
+            if (!player)
+                out.push_back(base->player_number);
+        });
+    }
+}
+
+//=============================================================================
+// Decoding
+//=============================================================================
+
+bool SnapshotCodec::readSequences(const uint8_t *data, size_t size, uint32_t &sequence, uint32_t &baseline)
+{
+    size_t pos = 0;
+
+    return Varint::read(data, size, pos, sequence) && Varint::read(data, size, pos, baseline);
+}
+
+bool SnapshotCodec::decode(const Snapshot *baseline, const uint8_t *data, size_t size, Snapshot &out)
+{
+    size_t pos = 0;
+    uint32_t sequence;
+    uint32_t baseline_sequence;
+    uint32_t common_dx;
+    uint32_t count;
+
+    if (!Varint::read(data, size, pos, sequence) || !Varint::read(data, size, pos, baseline_sequence) ||
+        !Varint::read(data, size, pos, common_dx))
+        return false;
+
+    if (baseline_sequence != 0 && (!baseline || baseline->sequence != baseline_sequence))
+        return false;
+
+    int32_t dx = Varint::zigzagDecode(common_dx);
+    int previous = -1;
+    size_t next = 0;
+    bool added = false;
+
+    out.sequence = sequence;
+    out.players.clear();
+
+    if (baseline_sequence != 0) {
+        out.players = baseline->players;
+
+        for (auto &player : out.players)
+            player.x += dx;
+    }
+
+    if (!Varint::read(data, size, pos, count))
+        return false;
+
+    // The changed records come in player number order like the baseline,
+    // so one cursor finds them all
+    for (uint32_t i = 0; i < count; i++) {
+        if (pos + 2 > size)
+            return false;
+
+        uint8_t player_number = data[pos++];
+        uint8_t mask = data[pos++];
+
+        if (player_number <= previous)
+            return false;
+        previous = player_number;
+
+        while (next < out.players.size() && out.players[next].player_number < player_number)
+            next++;
+
+        PlayerSnapshot *player;
+
+        if (next < out.players.size() && out.players[next].player_number == player_number) {
+            player = &out.players[next];
+        } else {
+            // Not in the baseline, sorted in once the records are read
+            out.players.push_back(PlayerSnapshot{player_number, 0, 0, 0, false});
+            player = &out.players.back();
+            added = true;
+        }
+
+        uint32_t delta;
+
+        if (mask & CHANGED_X) {
+            if (!Varint::read(data, size, pos, delta))
+                return false;
+            player->x += Varint::zigzagDecode(delta);
+        }
+        if (mask & CHANGED_Y) {
+            if (!Varint::read(data, size, pos, delta))
+                return false;
+            player->y += Varint::zigzagDecode(delta);
+        }
+        if (mask & CHANGED_SCORE) {
+            if (!Varint::read(data, size, pos, delta))
+                return false;
+            player->score += Varint::zigzagDecode(delta);
+        }
+        player->jet_active = (mask & JET_ACTIVE) != 0;
+    }
+
+    if (added)
+        std::sort(out.players.begin(), out.players.end(),
+                  [](const PlayerSnapshot &a, const PlayerSnapshot &b) {
+                      return a.player_number < b.player_number;
+                  });
+
+    if (!Varint::read(data, size, pos, count))
+        return false;
+
+    // Removed players are in order too, the others are moved down over them
+    size_t kept = 0;
+
+    next = 0;
+    previous = -1;
+    for (uint32_t i = 0; i < count; i++) {
+        if (pos >= size)
+            return false;
+
+        uint8_t player_number = data[pos++];
+
+        if (player_number <= previous)
+            return false;
+        previous = player_number;
+
+        while (next < out.players.size() && out.players[next].player_number < player_number)
+            out.players[kept++] = out.players[next++];
+        if (next < out.players.size() && out.players[next].player_number == player_number)
+            next++;
+    }
+
+    while (next < out.players.size())
+        out.players[kept++] = out.players[next++];
+    out.players.resize(kept);
+    return pos == size;
+}
@@ -0,0 +1,83 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef SNAPSHOT_HPP
+    #define SNAPSHOT_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "messages.hpp"
+#include "packet_io.hpp"
+
+// Game state at one tick, players sorted by player number
+struct Snapshot {
+    uint32_t sequence = 0;
+    std::vector<PlayerSnapshot> players;
+};
+
+// Last snapshots sent (server) or received (client), indexed by sequence
+class SnapshotHistory {
+public:
+    static const size_t SIZE = 32;
+
+private:
+    std::array<Snapshot, SIZE> ring;
+
+public:
+    void store(const Snapshot &snapshot);
+
+    // nullptr once the sequence was overwritten or never stored
+    const Snapshot *find(uint32_t sequence) const;
+};
+
+//=============================================================================
+// MSG_GAME_STATE records
+//
+// One record per player, laid out by StateRecordSchema (messages.hpp):
+// number, x, y, score (big-endian 16 bits) and the jetpack flag.
+//=============================================================================
+
+class StateRecords {
+public:
+    static const size_t RECORD_SIZE = StateRecordSchema::SIZE;
+
+    static void encode(const PlayerSnapshot &player, PacketWriter &writer);
+
+    // Replaces out with every complete record, a truncated one is ignored
+    static void decode(const uint8_t *data, size_t size, std::vector<PlayerSnapshot> &out);
+};
+
+//=============================================================================
+// MSG_GAME_STATE_DELTA codec
+//
+// Baseline players are first moved by one shared x delta. Only players
+// that differ from that prediction are written, as player number, a change
+// mask and zig-zag varint deltas of the changed fields. Baseline sequence 0
+// means "no baseline", every player is then encoded against a zero record.
+//=============================================================================
+
+class SnapshotCodec {
+public:
+    enum ChangeMask : uint8_t {
+        CHANGED_X = 1 << 0,
+        CHANGED_Y = 1 << 1,
+        CHANGED_SCORE = 1 << 2,
+        JET_ACTIVE = 1 << 3
+    };
+
+    // Both snapshots sorted by player number, one pass over each per field
+    static void encode(const Snapshot *baseline, const Snapshot &current, std::vector<uint8_t> &out);
+
+    // Reads the two sequences so the caller can look the baseline up
+    static bool readSequences(const uint8_t *data, size_t size, uint32_t &sequence, uint32_t &baseline);
+
+    static bool decode(const Snapshot *baseline, const uint8_t *data, size_t size, Snapshot &out);
+};
+
+#endif
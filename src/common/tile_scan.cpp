@@ -0,0 +1,129 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "tile_scan.hpp"
+
+#if defined(__x86_64__) || defined(__SSE2__)
+    #define TILE_SCAN_X86
+    #include <immintrin.h>
+#endif
+
+static inline bool isTile(char c)
+{
+    return c == '_' || c == 'c' || c == 'e';
+}
+
+size_t TileScan::findNonTileScalar(const char *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (!isTile(data[i]))
+            return i;
+    }
+    return size;
+}
+
+#ifdef TILE_SCAN_X86
+
+static size_t findNonTileSse2(const char *data, size_t size)
+{
+    const __m128i empty = _mm_set1_epi8('_');
+    const __m128i coin = _mm_set1_epi8('c');
+    const __m128i hazard = _mm_set1_epi8('e');
+    size_t i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i valid = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, empty),
+                                                  _mm_cmpeq_epi8(bytes, coin)),
+                                     _mm_cmpeq_epi8(bytes, hazard));
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(valid));
+
+        if (mask != 0xFFFF)
+            return i + __builtin_ctz(~mask);
+    }
+    return i + TileScan::findNonTileScalar(data + i, size - i);
+}
+
+__attribute__((target("avx2")))
+static size_t findNonTileAvx2(const char *data, size_t size)
+{
+    const __m256i empty = _mm256_set1_epi8('_');
+    const __m256i coin = _mm256_set1_epi8('c');
+    const __m256i hazard = _mm256_set1_epi8('e');
+    size_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        __m256i valid = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, empty),
+                                                        _mm256_cmpeq_epi8(bytes, coin)),
+                                        _mm256_cmpeq_epi8(bytes, hazard));
+        unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(valid));
+
+        if (mask != 0xFFFFFFFFu)
+            return i + __builtin_ctz(~mask);
+    }
+    return i + findNonTileSse2(data + i, size - i);
+}
+
+void TileScan::transpose(const char *const *rows, size_t x, char *dst, size_t dst_stride)
+{
+    __m128i a[16];
+    __m128i b[16];
+
+    for (int i = 0; i < 16; i++)
+        a[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[i] + x));
+
+    // Interleave bytes, then pairs, then quads, then halves: 4 rounds of
+    // unpacks turn 16 rows into 16 columns
+    for (int i = 0; i < 16; i += 2) {
+        b[i] = _mm_unpacklo_epi8(a[i], a[i + 1]);
+        b[i + 1] = _mm_unpackhi_epi8(a[i], a[i + 1]);
+    }
+    for (int i = 0; i < 16; i += 4) {
+        a[i] = _mm_unpacklo_epi16(b[i], b[i + 2]);
+        a[i + 1] = _mm_unpackhi_epi16(b[i], b[i + 2]);
+        a[i + 2] = _mm_unpacklo_epi16(b[i + 1], b[i + 3]);
+        a[i + 3] = _mm_unpackhi_epi16(b[i + 1], b[i + 3]);
+    }
+    for (int i = 0; i < 16; i += 8) {
+        for (int j = 0; j < 4; j++) {
+            b[i + 2 * j] = _mm_unpacklo_epi32(a[i + j], a[i + j + 4]);
+            b[i + 2 * j + 1] = _mm_unpackhi_epi32(a[i + j], a[i + j + 4]);
+        }
+    }
+    for (int j = 0; j < 8; j++) {
+        a[2 * j] = _mm_unpacklo_epi64(b[j], b[j + 8]);
+        a[2 * j + 1] = _mm_unpackhi_epi64(b[j], b[j + 8]);
+    }
+
+    for (int j = 0; j < 16; j++)
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + j * dst_stride), a[j]);
+}
+
+size_t TileScan::findNonTile(const char *data, size_t size)
+{
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+
+    return has_avx2 ? findNonTileAvx2(data, size) : findNonTileSse2(data, size);
+}
+
+#else
+
+size_t TileScan::findNonTile(const char *data, size_t size)
+{
+    return findNonTileScalar(data, size);
+}
+
+void TileScan::transpose(const char *const *rows, size_t x, char *dst, size_t dst_stride)
+{
+    for (size_t j = 0; j < TRANSPOSE_SIZE; j++) {
+        for (size_t i = 0; i < TRANSPOSE_SIZE; i++)
+            dst[j * dst_stride + i] = rows[i][x + j];
+    }
+}
+
+#endif
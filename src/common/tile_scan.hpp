@@ -0,0 +1,31 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef TILE_SCAN_HPP
+    #define TILE_SCAN_HPP
+
+#include <cstddef>
+
+// Vectorised helpers for loading map text. A map line is a run of '_', 'c'
+// and 'e', so finding the first byte outside that alphabet both validates
+// the line and finds where it ends ('\n'). Uses AVX2 when the cpu has it,
+// SSE2 on any x86-64, plain C++ elsewhere.
+class TileScan {
+public:
+    static const size_t TRANSPOSE_SIZE = 16;
+
+    // Index of the first byte that is not a tile, size if there is none
+    static size_t findNonTile(const char *data, size_t size);
+
+    static size_t findNonTileScalar(const char *data, size_t size);
+
+    // Copies a 16x16 square from row-major text (rows[i] + x is row i) to
+    // column-major storage (dst + j * dst_stride is column j)
+    static void transpose(const char *const *rows, size_t x, char *dst, size_t dst_stride);
+};
+
+#endif
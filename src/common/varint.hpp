@@ -0,0 +1,52 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef VARINT_HPP
+    #define VARINT_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Varints as MSG_GAME_STATE_DELTA and MSG_COIN_SYNC write them: 7 bits per
+// byte, least significant group first, high bit set when more bytes
+// follow. Signed values are zig-zag encoded first (0, -1, 1, -2... become
+// 0, 1, 2, 3...) so small deltas stay one byte.
+struct Varint {
+    static void write(std::vector<uint8_t> &out, uint32_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    // Reads one at data[pos] and moves pos past it, false when it runs
+    // past size or over 5 bytes
+    static bool read(const uint8_t *data, size_t size, size_t &pos, uint32_t &value)
+    {
+        value = 0;
+
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (pos >= size)
+                return false;
+
+            uint8_t byte = data[pos++];
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    static uint32_t zigzagEncode(int32_t value) { return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31); }
+    static int32_t zigzagDecode(uint32_t value) { return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1); }
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef CONNECTION_HPP
+    #define CONNECTION_HPP
+
+#include <chrono>
+#include <cstdint>
+#include "../common/frame_reader.hpp"
+#include "outbound_queue.hpp"
+
+// Per-socket transport state, independent from the PlayerTable game state
+struct Connection {
+    static const size_t RECV_BUFFER_SIZE = 1024;
+    static const uint32_t MAX_CLIENT_PAYLOAD = 256; // clients only send tiny messages
+
+    int fd;
+    FrameReader reader;
+    OutboundQueue outbound;
+
+    // EPOLLOUT is only armed while outbound has bytes left
+    bool write_armed;
+
+    // Queued in Server::dirty_clients, flushed once per loop iteration
+    bool flush_scheduled;
+
+    // Set when outbound crossed the high watermark, cleared under the low one
+    bool congested;
+    std::chrono::steady_clock::time_point congested_since;
+
+    // Scheduled for removal, nothing is read from or queued to it anymore
+    bool closing;
+
+    // From MSG_CONNECT, kept in case the client moves to another shard
+    uint8_t capabilities;
+
+    // A client that sends no MSG_CONNECT in time gets MSG_MAP_DATA anyway
+    std::chrono::steady_clock::time_point registered_at;
+
+    // Map transfer: chunks are queued a few at a time as outbound drains
+    bool map_sent;
+    uint32_t next_map_chunk;
+    uint32_t map_chunk_count;
+
+    // MSG_COIN_SYNC is answered once, the client only needs it when its
+    // map completes after the game started
+    bool coin_sync_sent;
+
+    explicit Connection(int fd)
+        : fd(fd), reader(RECV_BUFFER_SIZE, MAX_CLIENT_PAYLOAD), write_armed(false),
+          flush_scheduled(false), congested(false), closing(false), capabilities(0),
+          registered_at(std::chrono::steady_clock::now()), map_sent(false),
+          next_map_chunk(0), map_chunk_count(0), coin_sync_sent(false) {}
+};
+
+#endif
@@ -5,213 +5,314 @@
  ** JETPACK
  */
 
-#include "server.hpp"
-#include "player.hpp"
+#include "room.hpp"
+#include "../common/protocol.hpp"
+#include "../common/packet_io.hpp"
+#include "../common/messages.hpp"
 #include "../common/debug.hpp"
+#include <algorithm>
 
-void Server::startGame()
+void Room::startCountdown()
 {
-    if (players.size() < 2)
-        return;
-
-    DEBUG_LOG("Starting game countdown with " + std::to_string(players.size()) + " players");
-
-    // Ca marche qu a moitie
-    for (int count = 3; count >= 0; count--) {
+    DEBUG_LOG("Room " + std::to_string(room_id) + ": starting game countdown with " +
+              std::to_string(players.size()) + " players");
 
-        std::vector<uint8_t> payload = { static_cast<uint8_t>(count) };
-        std::vector<uint8_t> packet = Protocol::createPacket(MSG_COUNTDOWN, payload);
+    countdown = COUNTDOWN_FROM;
+    enterPhase(PHASE_COUNTDOWN, 0);
+    advanceCountdown();
+}
 
-        broadcastToAllClients(packet);
+void Room::advanceCountdown()
+{
+    broadcast(packet_pool.make<CountdownSchema>({ static_cast<uint8_t>(countdown) }));
 
-        if (count > 0)
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    if (countdown == 0) {
+        startGame();
+        return;
     }
 
-    std::vector<uint8_t> startPayload;
-    std::vector<uint8_t> startPacket = Protocol::createPacket(MSG_GAME_START, startPayload);
+    countdown--;
+    enterPhase(PHASE_COUNTDOWN, COUNTDOWN_STEP_MS);
+}
+
+void Room::startGame()
+{
+    initializePlayerPositions();
 
-    broadcastToAllClients(startPacket);
+    // Each client learns its own player number with the start message
+    for (size_t slot = 0; slot < players.size(); slot++) {
+        GameStartMessage start = { static_cast<uint8_t>(players.getPlayerNumber(slot)) };
 
-    game_started = true;
+        sink.sendToClient(players.getClientFd(slot), packet_pool.make<GameStartSchema>(start));
+    }
 
-    initializePlayerPositions();
+    enterPhase(PHASE_RUNNING, 0);
 
-    DEBUG_LOG("Game started with " + std::to_string(players.size()) + " players");
+    DEBUG_LOG("Room " + std::to_string(room_id) + ": game started with " +
+              std::to_string(players.size()) + " players");
 }
 
-void Server::initializePlayerPositions()
+void Room::initializePlayerPositions()
 {
-    int player_num = 0;
-
-    for (auto &pair : players) {
-        Player *player = pair.second;
-        player->setX(0);
-        player->setY(game_map.getHeight() - 3);
-        player->setPlayerNumber(player_num++);
+    for (size_t slot = 0; slot < players.size(); slot++) {
+        players.setPosition(slot, 0, game_map.getHeight() - 3);
+        players.setPlayerNumber(slot, slot);
+        players.clearCollectedCoins(slot);
     }
  }
 
-void Server::checkGameState()
+void Room::checkGameState()
 {
     checkGameOverConditions();
     updateAndSendGameState();
 }
 
-void Server::checkGameOverConditions()
+void Room::checkGameOverConditions()
 {
-    for (auto &pair : players) {
-
-        Player *player = pair.second;
-
-        player->moveForward();
-        player->applyPhysics();
+    // Physics for the whole match at once, then the rules player by player
+    players.step(static_cast<int>(game_map.getHeight()) - 1);
 
-        constrainPlayerToMap(player);
-        checkPlayerCollisions(pair.first, player);
+    for (size_t slot = 0; slot < players.size(); slot++) {
+        checkPlayerCollisions(slot);
 
-        if (player->getX() >= game_map.getWidth()) {
-            endGame(pair.first); //deter qui win
+        if (static_cast<size_t>(players.getX(slot)) >= game_map.getWidth()) {
+            endGame(players.getClientFd(slot)); //deter qui win
             return;
         }
     }
 }
 
-void Server::constrainPlayerToMap(Player *player)
+// The player went from (x - 1, previous_y) to (x, y): everything in the
+// new column between previous_y and y was crossed, not only (x, y). Coins
+// past the first hazard on the way are not reached. The map is never
+// modified, each player has its own set of collected coins.
+bool Room::checkPlayerCollisions(size_t slot)
 {
-    if (player->getY() < 0) {
-        player->setY(0);
-    } else if (player->getY() >= game_map.getHeight()) {
-        player->setY(game_map.getHeight() - 1);
+    int client_fd = players.getClientFd(slot);
+    size_t x = players.getX(slot);
+    size_t from = players.getPreviousY(slot);
+    size_t to = players.getY(slot);
+    size_t hazard_y = 0;
+    bool hazard = game_map.findFirst(Map::HAZARD_MASK, x, from, to, hazard_y);
+
+    if (hazard)
+        to = hazard_y;
+
+    game_map.forEach(Map::COIN_MASK, x, from, to, [&](size_t y) {
+        uint32_t index = 0;
+
+        if (game_map.getCoinIndex(x, y, index) && players.collectCoin(slot, index)) {
+            players.addScore(slot, 1);
+            notifyCollision(client_fd, 'c', x, y);
+        }
+    });
+
+    if (hazard) {
+        notifyCollision(client_fd, 'e', x, hazard_y);
+        endGame(findSurvivingWinner(slot));
+        return true;
     }
+    return false;
 }
 
-bool Server::checkPlayerCollisions(int client_fd, Player *player)
+// The best score among the players other than dead_slot wins, nobody when
+// the best score is shared (or there is nobody else)
+int Room::findSurvivingWinner(size_t dead_slot) const
 {
-    char tile = game_map.getTile(player->getX(), player->getY());
-
-    if (tile == 'c') {
-        player->addScore(1);
-        notifyCollision(client_fd, 'c', player->getX(), player->getY());
-    } else if (tile == 'e') {
-        notifyCollision(client_fd, 'e', player->getX(), player->getY());
-        for (auto &other_pair : players) {
-            if (other_pair.first != client_fd) {
-                endGame(other_pair.first);
-                return true;
-            }
+    size_t best = PlayerTable::NOT_FOUND;
+    bool shared = false;
+
+    for (size_t slot = 0; slot < players.size(); slot++) {
+        if (slot == dead_slot)
+            continue;
+
+        if (best == PlayerTable::NOT_FOUND || players.getScore(slot) > players.getScore(best)) {
+            best = slot;
+            shared = false;
+        } else if (players.getScore(slot) == players.getScore(best)) {
+            shared = true;
         }
     }
-    return false;
+    return best != PlayerTable::NOT_FOUND && !shared ? players.getClientFd(best) : -1;
 }
 
-void Server::updateAndSendGameState()
+void Room::updateAndSendGameState()
 {
-    std::vector<uint8_t> state_data;
-
     DEBUG_LOG("Updating game state for " + std::to_string(players.size()) + " players");
 
-    for (auto& pair : players) {
-        Player* player = pair.second;
+    for (size_t slot = 0; slot < players.size(); slot++) {
+        DEBUG_LOG("Player " + std::to_string(players.getPlayerNumber(slot)) +
+                  " state: pos=(" + std::to_string(players.getX(slot)) + "," +
+                  std::to_string(players.getY(slot)) + "), jet=" +
+                  (players.isJetActive(slot) ? "ON" : "OFF"));
+    }
 
-        DEBUG_LOG("Player " + std::to_string(player->getPlayerNumber()) +
-                  " state: pos=(" + std::to_string(player->getX()) + "," +
-                  std::to_string(player->getY()) + "), jet=" +
-                  (player->isJetActive() ? "ON" : "OFF"));
+    buildSnapshot();
+    sendGameState();
+}
 
-        addPlayerStateToPacket(state_data, player);
+void Room::buildSnapshot()
+{
+    current_snapshot.sequence = next_sequence++;
+    current_snapshot.players.clear();
+
+    for (size_t slot = 0; slot < players.size(); slot++) {
+        current_snapshot.players.push_back(PlayerSnapshot{
+            static_cast<uint8_t>(players.getPlayerNumber(slot)),
+            static_cast<uint16_t>(players.getX(slot)),
+            static_cast<uint16_t>(players.getY(slot)),
+            static_cast<uint16_t>(players.getScore(slot)),
+            players.isJetActive(slot)
+        });
     }
 
-    std::vector<uint8_t> state_packet = Protocol::createPacket(MSG_GAME_STATE, state_data);
+    std::sort(current_snapshot.players.begin(), current_snapshot.players.end(),
+              [](const PlayerSnapshot &a, const PlayerSnapshot &b) {
+                  return a.player_number < b.player_number;
+              });
 
-    broadcastToAllClients(state_packet);
+    snapshot_history.store(current_snapshot);
 }
 
-void Server::addPlayerStateToPacket(std::vector<uint8_t> &data, Player *player)
+// Packets come from the pool and the per-baseline cache keeps its
+// capacity, a tick does not allocate once the first ones warmed them up
+void Room::sendGameState()
 {
-    data.push_back(player->getPlayerNumber());
+    SharedPacket full_packet;
 
-    // X position 2 bytes
-    uint16_t x = player->getX();
-    data.push_back((x >> 8) & 0xFF);
-    data.push_back(x & 0xFF);
+    for (size_t slot = 0; slot < players.size(); slot++) {
+        int client_fd = players.getClientFd(slot);
 
-    // Y position 2 bytes
-    uint16_t y = player->getY();
-    data.push_back((y >> 8) & 0xFF);
-    data.push_back(y & 0xFF);
+        if (!players.hasCapability(slot, CAP_DELTA_STATE)) {
+            if (full_packet.empty())
+                full_packet = buildGameStatePacket();
+            sink.sendSnapshot(client_fd, full_packet);
+            continue;
+        }
+
+        const Snapshot *baseline = snapshot_history.find(players.getAckedSnapshot(slot));
+        uint32_t baseline_sequence = baseline ? baseline->sequence : 0;
+        SharedPacket *packet = nullptr;
+
+        // Clients acked on the same baseline get the same encoded delta
+        for (auto &cached : delta_packets) {
+            if (cached.first == baseline_sequence)
+                packet = &cached.second;
+        }
+
+        if (!packet) {
+            delta_data.clear();
+            SnapshotCodec::encode(baseline, current_snapshot, delta_data);
+
+            PacketWriter writer(packet_pool.acquire(sizeof(MessageHeader) + delta_data.size()),
+                                MSG_GAME_STATE_DELTA);
 
-    // Score 2 bytes
-    uint16_t score = player->getScore();
-    data.push_back((score >> 8) & 0xFF);
-    data.push_back(score & 0xFF);
+            writer.bytes(delta_data.data(), delta_data.size());
+            delta_packets.emplace_back(baseline_sequence, packet_pool.share(writer.finish()));
+            packet = &delta_packets.back().second;
+        }
+
+        sink.sendSnapshot(client_fd, *packet);
+    }
 
-    // Jetpack state 1 byte
-    data.push_back(player->isJetActive() ? 1 : 0);
+    // The send queues hold their own references, the pool gets the
+    // buffers back once they are flushed
+    delta_packets.clear();
 }
 
-void Server::handlePlayerInput(int client_fd, bool jet_activated)
+SharedPacket Room::buildGameStatePacket()
 {
-    auto it = players.find(client_fd);
+    PacketWriter writer(packet_pool.acquire(sizeof(MessageHeader) + players.size() * StateRecords::RECORD_SIZE),
+                        MSG_GAME_STATE);
 
-    if (it == players.end()) {
+    for (size_t slot = 0; slot < players.size(); slot++)
+        addPlayerStateToPacket(writer, slot);
+    return packet_pool.share(writer.finish());
+}
+
+void Room::addPlayerStateToPacket(PacketWriter &writer, size_t slot)
+{
+    StateRecords::encode(PlayerSnapshot{
+        static_cast<uint8_t>(players.getPlayerNumber(slot)),
+        static_cast<uint16_t>(players.getX(slot)),
+        static_cast<uint16_t>(players.getY(slot)),
+        static_cast<uint16_t>(players.getScore(slot)),
+        players.isJetActive(slot)
+    }, writer);
+}
+
+void Room::handlePlayerInput(int client_fd, bool jet_activated)
+{
+    size_t slot = players.find(client_fd);
+
+    if (slot == PlayerTable::NOT_FOUND) {
         DEBUG_LOG("Unknown input, dont try cheatin: " + std::to_string(client_fd));
         return;
     }
 
-    Player *player = it->second;
-    int player_number = player->getPlayerNumber();
+    int player_number = players.getPlayerNumber(slot);
 
     DEBUG_LOG("INPUT: client_fd=" + std::to_string(client_fd) +
               ", player_number=" + std::to_string(player_number) +
               ", jet=" + (jet_activated ? "ON" : "OFF"));
 
-    player->setJetActive(jet_activated);
+    players.setJetActive(slot, jet_activated);
 
-    for (const auto& p : players) {
-        DEBUG_LOG("PLAYER STATE: client_fd=" + std::to_string(p.first) +
-                  ", player_number=" + std::to_string(p.second->getPlayerNumber()) +
-                  ", jet=" + (p.second->isJetActive() ? "ON" : "OFF"));
+    for (size_t other = 0; other < players.size(); other++) {
+        DEBUG_LOG("PLAYER STATE: client_fd=" + std::to_string(players.getClientFd(other)) +
+                  ", player_number=" + std::to_string(players.getPlayerNumber(other)) +
+                  ", jet=" + (players.isJetActive(other) ? "ON" : "OFF"));
     }
 }
 
-void Server::notifyCollision(int client_fd, char collision_type, int x, int y)
+void Room::notifyCollision(int client_fd, char collision_type, int x, int y)
 {
-    std::vector<uint8_t> collision_data;
+    size_t slot = players.find(client_fd);
+    CollisionMessage collision = {
+        static_cast<uint8_t>(collision_type), static_cast<uint16_t>(x), static_cast<uint16_t>(y),
+        // Who collided, older clients stop reading after the position
+        static_cast<uint8_t>(slot != PlayerTable::NOT_FOUND ? players.getPlayerNumber(slot) : 0xFF)
+    };
+
+    broadcast(packet_pool.make<CollisionSchema>(collision));
+}
 
-    collision_data.push_back(collision_type);
+// Once per connection and as big as the coin runs, built outside of the
+// pool so the pool buffers stay packet sized
+void Room::sendCoinSync(int client_fd)
+{
+    for (size_t slot = 0; slot < players.size(); slot++) {
+        coin_data.clear();
+        players.getCollectedCoins(slot).encode(coin_data);
 
-    // Position 4 bytes total = x and y coordinates 2 + 2
-    uint16_t pos_x = x;
-    uint16_t pos_y = y;
-    collision_data.push_back((pos_x >> 8) & 0xFF);
-    collision_data.push_back(pos_x & 0xFF);
-    collision_data.push_back((pos_y >> 8) & 0xFF);
-    collision_data.push_back(pos_y & 0xFF);
+        // Sized to the encoded runs, the pool grows its buffer if needed
+        PacketWriter writer(packet_pool.acquire(sizeof(MessageHeader) + 1 + coin_data.size()), MSG_COIN_SYNC);
 
-    // Create and send collision packet
-    std::vector<uint8_t> collision_packet = Protocol::createPacket(MSG_COLLISION, collision_data);
-    broadcastToAllClients(collision_packet);
+        writer.u8(players.getPlayerNumber(slot));
+        writer.bytes(coin_data.data(), coin_data.size());
+
+        size_t size = writer.finish();
+
+        if (size == 0)
+            continue;
+        sink.sendToClient(client_fd, packet_pool.share(size));
+    }
 }
 
-void Server::endGame(int winner_fd)
+void Room::endGame(int winner_fd)
 {
-    if (!game_started)
+    if (phase != PHASE_RUNNING)
         return;
 
-    std::vector<uint8_t> end_data;
-
+    size_t winner = winner_fd >= 0 ? players.find(winner_fd) : PlayerTable::NOT_FOUND;
     // identify winner or 0xFF for no winner
-    if (winner_fd >= 0 && players.find(winner_fd) != players.end()) {
-        end_data.push_back(players[winner_fd]->getPlayerNumber());
-    } else {
-        end_data.push_back(0xFF);
-    }
+    GameEndMessage end = {
+        static_cast<uint8_t>(winner != PlayerTable::NOT_FOUND ? players.getPlayerNumber(winner) : 0xFF)
+    };
 
-    std::vector<uint8_t> end_packet = Protocol::createPacket(MSG_GAME_END, end_data);
-    broadcastToAllClients(end_packet);
+    broadcast(packet_pool.make<GameEndSchema>(end));
 
-    game_started = false;
+    phase = PHASE_FINISHED;
 
-    DEBUG_LOG("ITS OVER, WINNER IS: " + (winner_fd >= 0 ? std::to_string(players[winner_fd]->getPlayerNumber()) : "No winner ? You both suck"));
+    DEBUG_LOG("Room " + std::to_string(room_id) + ": ITS OVER, WINNER IS: " + (winner != PlayerTable::NOT_FOUND ? std::to_string(players.getPlayerNumber(winner)) : "No winner ? You both suck"));
 }
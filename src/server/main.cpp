@@ -5,7 +5,7 @@
  ** JETPACK
  */
 
-#include "server.hpp"
+#include "worker_pool.hpp"
 #include "../common/debug.hpp"
 #include <iostream>
 #include <cstring>
@@ -14,30 +14,55 @@
 
 void printUsage(const char  *programme)
 {
-    std::cerr << "Usage: " << programme << " -p <port> -m <map> [-d]" << std::endl;
+    std::cerr << "Usage: " << programme << " -p <port> -m <map> [-d] [-t <rate>] [-r <players>] [-j <workers>] [-a] [-u] [-H <bytes>] [-L <bytes>]" << std::endl;
     std::cerr << "  -p <port>   Port to listen on" << std::endl;
     std::cerr << "  -m <map>    Path to map file" << std::endl;
     std::cerr << "  -d          Enable debug mode" << std::endl;
+    std::cerr << "  -t <rate>   Simulation ticks per second (default 10)" << std::endl;
+    std::cerr << "  -r <players> Players per match (default 2)" << std::endl;
+    std::cerr << "  -j <workers> Worker threads, each with its own rooms (default 1)" << std::endl;
+    std::cerr << "  -a          Pin each worker thread to a cpu" << std::endl;
+    std::cerr << "  -u          Offer clients a UDP channel for game state" << std::endl;
+    std::cerr << "  -H <bytes>  Send queue high watermark (slow clients get kicked)" << std::endl;
+    std::cerr << "  -L <bytes>  Send queue low watermark" << std::endl;
 }
 
 int main(int argc, char** argv)
 {
-    int port = -1;
+    ServerConfig config;
     int opt;
-    std::string map_path;
-    bool debug_mode = false;
 
-
-    while ((opt = getopt(argc, argv, "p:m:d")) != -1) {
+    while ((opt = getopt(argc, argv, "p:m:dt:r:j:auH:L:")) != -1) {
         switch (opt) {
             case 'p':
-                port = std::atoi(optarg);
+                config.port = std::atoi(optarg);
                 break;
             case 'm':
-                map_path = optarg;
+                config.map_path = optarg;
                 break;
             case 'd':
-                debug_mode = true;
+                config.debug_mode = true;
+                break;
+            case 't':
+                config.tick_rate = std::atoi(optarg);
+                break;
+            case 'r':
+                config.players_per_match = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'j':
+                config.worker_threads = std::atoi(optarg);
+                break;
+            case 'a':
+                config.pin_threads = true;
+                break;
+            case 'u':
+                config.udp_enabled = true;
+                break;
+            case 'H':
+                config.send_high_watermark = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'L':
+                config.send_low_watermark = std::strtoul(optarg, nullptr, 10);
                 break;
             default:
                 printUsage(argv[0]);
@@ -45,19 +70,22 @@ int main(int argc, char** argv)
         }
     }
 
-    if (port <= 0 || map_path.empty()) {
+    if (config.port <= 0 || config.map_path.empty() || config.tick_rate <= 0 ||
+        config.players_per_match < 2 || config.players_per_match > 255 ||
+        config.worker_threads < 1 ||
+        config.send_low_watermark > config.send_high_watermark) {
         printUsage(argv[0]);
         return 1;
     }
 
-    Server server(port, map_path, debug_mode);
+    WorkerPool pool(config);
 
-    if (!server.initialize()) {
+    if (!pool.initialize()) {
         std::cerr << "Something aint right with the server." << std::endl;
         return 1;
     }
 
-    server.run();
+    pool.run();
 
     return 0;
 }
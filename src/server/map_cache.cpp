@@ -0,0 +1,145 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "map_cache.hpp"
+#include "../common/protocol.hpp"
+#include "../common/messages.hpp"
+#include "../common/debug.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+MapCache::MapCache() : memfd(-1), full_map{0, 0}, info{0, 0}
+{}
+
+MapCache::~MapCache()
+{
+    if (memfd >= 0)
+        close(memfd);
+}
+
+MapCache::Entry MapCache::reserve(off_t &offset, size_t payload_size)
+{
+    Entry entry = { offset, sizeof(MessageHeader) + payload_size };
+
+    offset += entry.length;
+    return entry;
+}
+
+bool MapCache::build(const Map &game_map)
+{
+    size_t width = game_map.getWidth();
+    size_t height = game_map.getHeight();
+    size_t chunk_columns = game_map.getChunkColumns();
+    size_t map_data_size = MapDataHeaderSchema::SIZE + width * height;
+    off_t size = 0;
+
+    // MSG_MAP_DATA is only for clients without CAP_MAP_CHUNKS
+    if (map_data_size <= Protocol::MAX_PAYLOAD_SIZE)
+        full_map = reserve(size, map_data_size);
+
+    info = reserve(size, Map::INFO_SIZE);
+
+    chunks.clear();
+    chunks.reserve(game_map.getChunkCount());
+
+    for (size_t first = 0; first < width; first += chunk_columns) {
+        size_t count = std::min(chunk_columns, width - first);
+
+        chunks.push_back(reserve(size, Map::CHUNK_HEADER_SIZE + count * height));
+    }
+
+    DEBUG_LOG("Map packets laid out: " + std::to_string(size) + " bytes, " +
+              std::to_string(chunks.size()) + " chunks");
+
+    if (!createImage(size))
+        return false;
+
+    if (full_map.length > 0 && !store(full_map, MSG_MAP_DATA, game_map.serialize()))
+        return false;
+    if (!store(info, MSG_MAP_INFO, game_map.serializeInfo()))
+        return false;
+
+    for (size_t index = 0; index < chunks.size(); index++) {
+        if (!store(chunks[index], MSG_MAP_CHUNK, game_map.serializeChunk(index)))
+            return false;
+    }
+    return true;
+}
+
+bool MapCache::createImage(off_t size)
+{
+    memfd = memfd_create("jetpack-map", MFD_CLOEXEC);
+
+    if (memfd >= 0 && ftruncate(memfd, size) == 0)
+        return true;
+
+    if (memfd >= 0) {
+        close(memfd);
+        memfd = -1;
+    }
+
+    DEBUG_LOG("No memfd for the map cache, falling back to shared buffers");
+    image = std::make_shared<std::vector<uint8_t>>(size);
+    return true;
+}
+
+bool MapCache::store(const Entry &entry, uint8_t type, const std::vector<uint8_t> &payload)
+{
+    MessageHeader header;
+
+    header.type = static_cast<MessageType>(type);
+    Protocol::setPayloadSize(header, payload.size());
+
+    if (memfd < 0) {
+        memcpy(image->data() + entry.offset, &header, sizeof(MessageHeader));
+        memcpy(image->data() + entry.offset + sizeof(MessageHeader), payload.data(), payload.size());
+        return true;
+    }
+
+    struct iovec iov[2] = {
+        { &header, sizeof(MessageHeader) },
+        { const_cast<uint8_t *>(payload.data()), payload.size() }
+    };
+    off_t offset = entry.offset;
+    size_t written = 0;
+
+    while (written < entry.length) {
+        ssize_t result = pwritev(memfd, iov, 2, offset);
+
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0) {
+            std::cerr << "Cannot write the map cache, errno=" << errno << std::endl;
+            return false;
+        }
+
+        // Partial write: skip what went out and retry with the rest
+        written += result;
+        offset += result;
+        for (auto &vec : iov) {
+            size_t skip = std::min(static_cast<size_t>(result), vec.iov_len);
+
+            vec.iov_base = static_cast<uint8_t *>(vec.iov_base) + skip;
+            vec.iov_len -= skip;
+            result -= skip;
+        }
+    }
+    return true;
+}
+
+SharedPacket MapCache::slice(const Entry &entry) const
+{
+    if (!image)
+        return SharedPacket();
+
+    return SharedPacket(image, entry.offset, entry.length);
+}
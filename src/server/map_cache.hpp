@@ -0,0 +1,76 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef MAP_CACHE_HPP
+    #define MAP_CACHE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <sys/types.h>
+#include "../common/map.hpp"
+#include "../common/packet.hpp"
+
+// Every map packet a client can ask for (MSG_MAP_DATA, MSG_MAP_INFO and
+// each MSG_MAP_CHUNK), laid out in one image shared by all shards. The
+// image lives in a memfd so connections send it with sendfile(), straight
+// from the page cache. Without memfd it stays in memory and connections
+// queue slices of it.
+//
+// build() lays the image out from the map dimensions and encodes every
+// packet before the shards start, so the connect path only ever reads it.
+class MapCache {
+public:
+    struct Entry {
+        off_t offset;
+        size_t length;
+    };
+
+private:
+    int memfd;
+    std::shared_ptr<std::vector<uint8_t>> image;
+
+    Entry full_map;     // empty when the map does not fit in one message
+    Entry info;
+    std::vector<Entry> chunks;
+
+    Entry reserve(off_t &offset, size_t payload_size);
+
+    bool createImage(off_t size);
+
+    bool store(const Entry &entry, uint8_t type, const std::vector<uint8_t> &payload);
+
+public:
+    MapCache();
+
+    ~MapCache();
+
+    MapCache(const MapCache &) = delete;
+    MapCache &operator=(const MapCache &) = delete;
+
+    // False when a packet could not be written, the server does not start
+    // without its map
+    bool build(const Map &map);
+
+    // -1 when the image could not be put in a memfd
+    int getFd() const { return memfd; }
+
+    // An empty entry for the full map when it does not fit in one message
+    const Entry &getFullMap() const { return full_map; }
+    const Entry &getInfo() const { return info; }
+    const Entry &getChunk(size_t index) const { return chunks[index]; }
+    size_t getChunkCount() const { return chunks.size(); }
+
+    // False when the map does not fit in one MSG_MAP_DATA
+    bool hasFullMap() const { return full_map.length > 0; }
+
+    // In memory copy of an entry, only valid when getFd() is -1
+    SharedPacket slice(const Entry &entry) const;
+};
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "matchmaker.hpp"
+#include "../common/debug.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+Matchmaker::Matchmaker(size_t shard_count)
+    : shard_count(shard_count), inboxes(std::make_unique<Inbox[]>(shard_count)), open_shard(NO_SHARD)
+{
+    for (size_t i = 0; i < shard_count; i++) {
+        inboxes[i].head.store(nullptr, std::memory_order_relaxed);
+        inboxes[i].event_fd = -1;
+    }
+}
+
+Matchmaker::~Matchmaker()
+{
+    for (size_t i = 0; i < shard_count; i++) {
+        Node *node = inboxes[i].head.exchange(nullptr, std::memory_order_acquire);
+
+        while (node) {
+            Node *next = node->next;
+
+            close(node->handoff.fd);
+            delete node;
+            node = next;
+        }
+
+        if (inboxes[i].event_fd >= 0)
+            close(inboxes[i].event_fd);
+    }
+}
+
+bool Matchmaker::initialize()
+{
+    for (size_t i = 0; i < shard_count; i++) {
+        inboxes[i].event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (inboxes[i].event_fd < 0) {
+            DEBUG_LOG("eventfd failed, errno=" + std::to_string(errno));
+            return false;
+        }
+    }
+    return true;
+}
+
+int Matchmaker::claim(int shard)
+{
+    int open = open_shard.load(std::memory_order_acquire);
+
+    // On failure open holds the shard that got there first
+    if (open == NO_SHARD && open_shard.compare_exchange_strong(open, shard, std::memory_order_acq_rel))
+        return shard;
+    return open;
+}
+
+void Matchmaker::release(int shard)
+{
+    int open = shard;
+
+    open_shard.compare_exchange_strong(open, NO_SHARD, std::memory_order_acq_rel);
+}
+
+void Matchmaker::handOff(int shard, const Handoff &handoff)
+{
+    Inbox &inbox = inboxes[shard];
+    Node *node = new Node{ handoff, inbox.head.load(std::memory_order_relaxed) };
+
+    while (!inbox.head.compare_exchange_weak(node->next, node, std::memory_order_release,
+                                             std::memory_order_relaxed))
+        ;
+
+    uint64_t one = 1;
+
+    if (write(inbox.event_fd, &one, sizeof(one)) != sizeof(one))
+        DEBUG_LOG("Could not wake shard " + std::to_string(shard) + ", errno=" + std::to_string(errno));
+}
+
+void Matchmaker::collect(int shard, std::vector<Handoff> &handoffs)
+{
+    Inbox &inbox = inboxes[shard];
+    uint64_t count = 0;
+
+    handoffs.clear();
+
+    // Reset first: whatever is pushed after the exchange wakes us up again
+    if (read(inbox.event_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+        DEBUG_LOG("eventfd read failed, errno=" + std::to_string(errno));
+
+    Node *node = inbox.head.exchange(nullptr, std::memory_order_acquire);
+
+    while (node) {
+        Node *next = node->next;
+
+        handoffs.push_back(node->handoff);
+        delete node;
+        node = next;
+    }
+
+    // The list is newest first
+    std::reverse(handoffs.begin(), handoffs.end());
+}
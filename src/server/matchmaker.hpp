@@ -0,0 +1,78 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef MATCHMAKER_HPP
+    #define MATCHMAKER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Keeps the players of one match on one shard. SO_REUSEPORT hands every
+// connection to whichever listener the kernel picks, so one shard at a
+// time holds the open waiting room and the others pass their new players
+// to it. The open room moves on once it is full: the next player to
+// connect opens one on the shard that accepted it.
+//
+// A hand-off is a lock-free list per shard, pushed by any shard and taken
+// whole by its owner, and an eventfd in the owner's reactor to wake it up.
+// Nothing on the tick path ever waits for another shard.
+class Matchmaker {
+public:
+    static const int NO_SHARD = -1;
+
+    // A connection on its way to another shard
+    struct Handoff {
+        int fd;
+        uint8_t capabilities;
+        bool connected;     // MSG_CONNECT handled, the whole map already sent
+    };
+
+private:
+    struct Node {
+        Handoff handoff;
+        Node *next;
+    };
+
+    struct Inbox {
+        std::atomic<Node *> head;
+        int event_fd;
+    };
+
+    size_t shard_count;
+    std::unique_ptr<Inbox[]> inboxes;
+    std::atomic<int> open_shard;
+
+public:
+    explicit Matchmaker(size_t shard_count);
+
+    // Closes the connections that were never collected
+    ~Matchmaker();
+
+    Matchmaker(const Matchmaker &) = delete;
+    Matchmaker &operator=(const Matchmaker &) = delete;
+
+    bool initialize();
+
+    int getEventFd(int shard) const { return inboxes[shard].event_fd; }
+
+    // The shard holding the open waiting room, shard itself when it just
+    // became that shard because nobody was
+    int claim(int shard);
+
+    // The waiting room of shard is full
+    void release(int shard);
+
+    void handOff(int shard, const Handoff &handoff);
+
+    // Everything handed to shard so far, oldest first
+    void collect(int shard, std::vector<Handoff> &handoffs);
+};
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "outbound_queue.hpp"
+#include "../common/debug.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+
+OutboundQueue::OutboundQueue() : head(0), head_offset(0), queued_bytes(0)
+{}
+
+void OutboundQueue::push(const SharedPacket &packet)
+{
+    if (packet.empty())
+        return;
+
+    packets.push_back({ packet, -1, 0, packet.size() });
+    queued_bytes += packet.size();
+}
+
+void OutboundQueue::pushFile(int file_fd, off_t offset, size_t length)
+{
+    if (length == 0)
+        return;
+
+    packets.push_back({ SharedPacket(), file_fd, offset, length });
+    queued_bytes += length;
+}
+
+void OutboundQueue::popFront()
+{
+    // Drops the reference now, the packet buffer can go back to its pool
+    packets[head++] = Entry{};
+    head_offset = 0;
+
+    if (head == packets.size()) {
+        packets.clear();
+        head = 0;
+    } else if (head >= COMPACT_AFTER && head * 2 >= packets.size()) {
+        // A client that never fully drains, moving what is left is cheap
+        packets.erase(packets.begin(), packets.begin() + head);
+        head = 0;
+    }
+}
+
+void OutboundQueue::consume(size_t bytes)
+{
+    queued_bytes -= bytes;
+
+    while (bytes > 0) {
+        size_t remaining = packets[head].length - head_offset;
+
+        if (bytes < remaining) {
+            head_offset += bytes;
+            return;
+        }
+
+        bytes -= remaining;
+        popFront();
+    }
+}
+
+OutboundQueue::FlushResult OutboundQueue::sendFileRange(int fd, const Entry &entry, size_t &bytes_sent)
+{
+    off_t offset = entry.file_offset + head_offset;
+    ssize_t result;
+
+    do {
+        result = sendfile(fd, entry.file_fd, &offset, entry.length - head_offset);
+    } while (result < 0 && errno == EINTR);
+
+    if (result < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return FLUSH_PENDING;
+        DEBUG_LOG("Failed to sendfile to client: " + std::to_string(fd) +
+                  ", errno=" + std::to_string(errno));
+        return FLUSH_ERROR;
+    }
+
+    bytes_sent = result;
+    return FLUSH_DONE;
+}
+
+OutboundQueue::FlushResult OutboundQueue::flush(int fd)
+{
+    while (head < packets.size()) {
+        if (packets[head].file_fd >= 0) {
+            size_t bytes_sent = 0;
+            size_t batch_bytes = packets[head].length - head_offset;
+            FlushResult result = sendFileRange(fd, packets[head], bytes_sent);
+
+            if (result != FLUSH_DONE)
+                return result;
+
+            consume(bytes_sent);
+
+            if (bytes_sent < batch_bytes)
+                return FLUSH_PENDING;
+            continue;
+        }
+
+        struct iovec iov[MAX_IOV];
+        size_t iov_count = 0;
+        size_t batch_bytes = 0;
+
+        // Memory packets up to the next file range go out in one sendmsg
+        for (auto it = packets.begin() + head; it != packets.end() && it->file_fd < 0 &&
+             iov_count < MAX_IOV; it++) {
+            size_t offset = (iov_count == 0) ? head_offset : 0;
+
+            iov[iov_count].iov_base = const_cast<uint8_t *>(it->packet.data() + offset);
+            iov[iov_count].iov_len = it->length - offset;
+            batch_bytes += iov[iov_count].iov_len;
+            iov_count++;
+        }
+
+        struct msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov_count;
+
+        ssize_t bytes_sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+
+        if (bytes_sent < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return FLUSH_PENDING;
+            DEBUG_LOG("Failed to send data to client: " + std::to_string(fd) +
+                      ", errno=" + std::to_string(errno));
+            return FLUSH_ERROR;
+        }
+
+        DEBUG_PACKET_SEND(static_cast<const char*>(iov[0].iov_base),
+                          std::min<size_t>(bytes_sent, iov[0].iov_len));
+
+        consume(bytes_sent);
+
+        if (static_cast<size_t>(bytes_sent) < batch_bytes)
+            return FLUSH_PENDING;
+    }
+    return FLUSH_DONE;
+}
@@ -0,0 +1,70 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef OUTBOUND_QUEUE_HPP
+    #define OUTBOUND_QUEUE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <sys/types.h>
+#include "../common/packet.hpp"
+
+// Packets waiting to be written to one non-blocking socket. The queue only
+// holds references to shared encoded packets, flush() gathers them into a
+// single sendmsg(). Byte ranges of a file are sent with sendfile() instead.
+// A short write just advances head_offset so framing is never corrupted.
+class OutboundQueue {
+public:
+    enum FlushResult {
+        FLUSH_DONE,
+        FLUSH_PENDING,
+        FLUSH_ERROR
+    };
+
+private:
+    static const size_t MAX_IOV = 64;
+
+    // Either an in-memory packet or a range of file_fd
+    struct Entry {
+        SharedPacket packet;
+        int file_fd;
+        off_t file_offset;
+        size_t length;
+    };
+
+    // Sent entries before head are dropped in bulk, the vector keeps its
+    // capacity so a queue that fills and drains every tick never allocates
+    std::vector<Entry> packets;
+    size_t head;
+    size_t head_offset;
+    size_t queued_bytes;
+
+    static const size_t COMPACT_AFTER = 64;
+
+    void consume(size_t bytes);
+
+    void popFront();
+
+    FlushResult sendFileRange(int fd, const Entry &entry, size_t &bytes_sent);
+
+public:
+    OutboundQueue();
+
+    void push(const SharedPacket &packet);
+
+    // The file must stay open and unchanged until the range is sent
+    void pushFile(int file_fd, off_t offset, size_t length);
+
+    // Writes until the queue is empty or the socket would block
+    FlushResult flush(int fd);
+
+    size_t size() const { return queued_bytes; }
+    bool empty() const { return queued_bytes == 0; }
+};
+
+#endif
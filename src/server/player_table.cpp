@@ -0,0 +1,111 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "player_table.hpp"
+#include <algorithm>
+
+size_t PlayerTable::add(int fd)
+{
+    auto it = slots.find(fd);
+
+    if (it != slots.end())
+        return it->second;
+
+    size_t slot = client_fd.size();
+
+    x.push_back(0);
+    y.push_back(0);
+    previous_y.push_back(0);
+    fixed_y.push_back(0);
+    y_velocity.push_back(0);
+    jet_active.push_back(0);
+    score.push_back(0);
+    player_number.push_back(0);
+    collected_coins.emplace_back();
+    client_fd.push_back(fd);
+    capabilities.push_back(0);
+    acked_snapshot.push_back(0);
+
+    slots[fd] = slot;
+    return slot;
+}
+
+template <typename T>
+static void moveLast(std::vector<T> &field, size_t slot)
+{
+    if (slot != field.size() - 1)
+        field[slot] = std::move(field.back());
+    field.pop_back();
+}
+
+bool PlayerTable::remove(int fd)
+{
+    auto it = slots.find(fd);
+
+    if (it == slots.end())
+        return false;
+
+    size_t slot = it->second;
+
+    slots.erase(it);
+    if (slot != client_fd.size() - 1)
+        slots[client_fd.back()] = slot;
+
+    moveLast(x, slot);
+    moveLast(y, slot);
+    moveLast(previous_y, slot);
+    moveLast(fixed_y, slot);
+    moveLast(y_velocity, slot);
+    moveLast(jet_active, slot);
+    moveLast(score, slot);
+    moveLast(player_number, slot);
+    moveLast(collected_coins, slot);
+    moveLast(client_fd, slot);
+    moveLast(capabilities, slot);
+    moveLast(acked_snapshot, slot);
+    return true;
+}
+
+size_t PlayerTable::find(int fd) const
+{
+    auto it = slots.find(fd);
+
+    return it != slots.end() ? it->second : NOT_FOUND;
+}
+
+void PlayerTable::setPosition(size_t slot, int new_x, int new_y)
+{
+    x[slot] = new_x;
+    y[slot] = new_y;
+    previous_y[slot] = new_y;
+    fixed_y[slot] = Physics::fromTile(new_y);
+    y_velocity[slot] = 0;
+}
+
+// The physics constants are in physics.hpp
+
+// The arrays are distinct vectors, saying so saves the compiler the
+// overlap checks it would otherwise need before vectorising
+static void stepSlots(size_t count, int max_y, int *__restrict__ xs, int *__restrict__ ys,
+                      int *__restrict__ previous, Physics::Fixed *__restrict__ fixed,
+                      Physics::Fixed *__restrict__ velocity, const uint8_t *__restrict__ jet)
+{
+    // No branch, no call: the same integer operations for every slot
+    for (size_t i = 0; i < count; i++) {
+        Physics::step(fixed[i], velocity[i], jet[i] != 0, max_y);
+
+        previous[i] = ys[i];
+        xs[i] += PlayerTable::FORWARD_SPEED;
+        ys[i] = Physics::toTile(fixed[i]);
+    }
+}
+
+void PlayerTable::step(int max_y)
+{
+    stepSlots(size(), max_y, x.data(), y.data(), previous_y.data(), fixed_y.data(),
+              y_velocity.data(), jet_active.data());
+}
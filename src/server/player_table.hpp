@@ -0,0 +1,102 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef PLAYER_TABLE_HPP
+    #define PLAYER_TABLE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+#include "../common/coin_set.hpp"
+#include "../common/physics.hpp"
+
+// Players of one match, one array per field. The client fd is the handle,
+// slots stay dense: removing a player moves the last one into its slot, so
+// a slot number is only valid until the next remove().
+//
+// The fields step() touches every tick sit in their own arrays, the
+// physics is then one loop over plain arrays that the compiler can
+// vectorise however many players the match has. Vertical position and
+// velocity are Physics fixed point, y is the row they round down to.
+class PlayerTable {
+public:
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    // Gravity and jet are in physics.hpp
+    static constexpr int FORWARD_SPEED = 1;
+
+private:
+    // Physics, read and written by step()
+    std::vector<int> x;
+    std::vector<int> y;
+    std::vector<int> previous_y;
+    std::vector<Physics::Fixed> fixed_y;
+    std::vector<Physics::Fixed> y_velocity;
+    std::vector<uint8_t> jet_active;
+
+    // Game state
+    std::vector<int> score;
+    std::vector<int> player_number;
+    std::vector<CoinSet> collected_coins;
+
+    // Protocol
+    std::vector<int> client_fd;
+    std::vector<uint8_t> capabilities;
+    std::vector<uint32_t> acked_snapshot;
+
+    std::unordered_map<int, size_t> slots;
+
+public:
+    // Slot of the new player, or of the existing one with that fd
+    size_t add(int fd);
+
+    bool remove(int fd);
+
+    size_t find(int fd) const;
+
+    size_t size() const { return client_fd.size(); }
+    bool empty() const { return client_fd.empty(); }
+
+    int getClientFd(size_t slot) const { return client_fd[slot]; }
+
+    int getPlayerNumber(size_t slot) const { return player_number[slot]; }
+    void setPlayerNumber(size_t slot, int number) { player_number[slot] = number; }
+
+    int getX(size_t slot) const { return x[slot]; }
+    int getY(size_t slot) const { return y[slot]; }
+    int getPreviousY(size_t slot) const { return previous_y[slot]; }
+    Physics::Fixed getFixedY(size_t slot) const { return fixed_y[slot]; }
+    Physics::Fixed getVelocity(size_t slot) const { return y_velocity[slot]; }
+
+    // Top of the tile, not moving
+    void setPosition(size_t slot, int new_x, int new_y);
+
+    int getScore(size_t slot) const { return score[slot]; }
+    void addScore(size_t slot, int points) { score[slot] += points; }
+
+    bool isJetActive(size_t slot) const { return jet_active[slot] != 0; }
+    void setJetActive(size_t slot, bool active) { jet_active[slot] = active; }
+
+    // False when this player already has the coin
+    bool collectCoin(size_t slot, uint32_t index) { return collected_coins[slot].insert(index); }
+    const CoinSet &getCollectedCoins(size_t slot) const { return collected_coins[slot]; }
+    void clearCollectedCoins(size_t slot) { collected_coins[slot].clear(); }
+
+    bool hasCapability(size_t slot, uint8_t capability) const { return (capabilities[slot] & capability) != 0; }
+    void setCapabilities(size_t slot, uint8_t caps) { capabilities[slot] = caps; }
+
+    uint32_t getAckedSnapshot(size_t slot) const { return acked_snapshot[slot]; }
+    void setAckedSnapshot(size_t slot, uint32_t sequence) { acked_snapshot[slot] = sequence; }
+
+    // One tick of every player: a column forward, gravity or jet, y kept in
+    // 0..max_y. The y before the move stays in getPreviousY() for the
+    // swept collision check.
+    void step(int max_y);
+};
+
+#endif
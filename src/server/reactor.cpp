@@ -0,0 +1,77 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "reactor.hpp"
+#include "../common/debug.hpp"
+#include <unistd.h>
+#include <cerrno>
+
+Reactor::Reactor() : epoll_fd(-1), ready_count(0), ready_events(MAX_EVENTS)
+{}
+
+Reactor::~Reactor()
+{
+    if (epoll_fd >= 0)
+        close(epoll_fd);
+}
+
+bool Reactor::initialize()
+{
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+    if (epoll_fd < 0) {
+        DEBUG_LOG("epoll_create1 failed, errno=" + std::to_string(errno));
+        return false;
+    }
+    return true;
+}
+
+bool Reactor::add(int fd, uint32_t events)
+{
+    epoll_event ev = {};
+    ev.events = events | EPOLLET;
+    ev.data.fd = fd;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        DEBUG_LOG("epoll_ctl ADD failed for fd=" + std::to_string(fd) +
+                  ", errno=" + std::to_string(errno));
+        return false;
+    }
+    return true;
+}
+
+bool Reactor::modify(int fd, uint32_t events)
+{
+    epoll_event ev = {};
+    ev.events = events | EPOLLET;
+    ev.data.fd = fd;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        DEBUG_LOG("epoll_ctl MOD failed for fd=" + std::to_string(fd) +
+                  ", errno=" + std::to_string(errno));
+        return false;
+    }
+    return true;
+}
+
+void Reactor::remove(int fd)
+{
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int Reactor::wait(int timeout_ms)
+{
+    ready_count = epoll_wait(epoll_fd, ready_events.data(), MAX_EVENTS, timeout_ms);
+
+    if (ready_count < 0) {
+        int saved_errno = errno;
+        ready_count = 0;
+        errno = saved_errno;
+        return -1;
+    }
+    return ready_count;
+}
@@ -0,0 +1,49 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef REACTOR_HPP
+    #define REACTOR_HPP
+
+#include <vector>
+#include <cstdint>
+#include <sys/epoll.h>
+
+// Thin wrapper around epoll. Every fd is registered edge-triggered, so the
+// owner has to drain a socket (accept/recv until EAGAIN) once it is reported.
+// Cost per wait() only depends on how many fds are ready.
+class Reactor {
+private:
+    int epoll_fd;
+    int ready_count;
+    std::vector<epoll_event> ready_events;
+
+public:
+    static const int MAX_EVENTS = 256;
+
+    Reactor();
+
+    ~Reactor();
+
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    bool initialize();
+
+    bool add(int fd, uint32_t events);
+
+    bool modify(int fd, uint32_t events);
+
+    void remove(int fd);
+
+    int wait(int timeout_ms);
+
+    int getReadyCount() const { return ready_count; }
+    int getReadyFd(int index) const { return ready_events[index].data.fd; }
+    uint32_t getReadyEvents(int index) const { return ready_events[index].events; }
+};
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "room.hpp"
+#include "../common/protocol.hpp"
+#include "../common/debug.hpp"
+
+Room::Room(int room_id, RoomSink &sink, const Map &game_map, size_t match_size, int tick_rate)
+    : room_id(room_id), sink(sink), game_map(game_map), match_size(match_size),
+      tick_rate(tick_rate), phase(PHASE_WAITING), current_tick(0), phase_deadline(0),
+      countdown(0), next_sequence(1) {
+}
+
+void Room::addPlayer(int client_fd)
+{
+    players.add(client_fd);
+
+    DEBUG_LOG("Room " + std::to_string(room_id) + ": client " + std::to_string(client_fd) +
+              " joined (" + std::to_string(players.size()) + "/" + std::to_string(match_size) + ")");
+}
+
+void Room::removePlayer(int client_fd)
+{
+    if (!players.remove(client_fd))
+        return;
+
+    handlePlayerDisconnection();
+}
+
+void Room::setCapabilities(int client_fd, uint8_t capabilities)
+{
+    size_t slot = players.find(client_fd);
+
+    if (slot != PlayerTable::NOT_FOUND)
+        players.setCapabilities(slot, capabilities);
+}
+
+void Room::handleStateAck(int client_fd, uint32_t sequence)
+{
+    size_t slot = players.find(client_fd);
+
+    // Acks for snapshots we never sent are ignored
+    if (slot == PlayerTable::NOT_FOUND || sequence >= next_sequence)
+        return;
+
+    if (sequence > players.getAckedSnapshot(slot))
+        players.setAckedSnapshot(slot, sequence);
+}
+
+void Room::handlePlayerDisconnection()
+{
+    if ((phase == PHASE_STARTING || phase == PHASE_COUNTDOWN) && players.size() < match_size) {
+        DEBUG_LOG("Room " + std::to_string(room_id) + ": player left before the start, waiting again");
+        enterPhase(PHASE_WAITING, 0);
+        return;
+    }
+
+    if (phase == PHASE_RUNNING && players.size() < 2) {
+        if (players.size() == 1) {
+            endGame(players.getClientFd(0));
+        } else {
+            phase = PHASE_FINISHED;
+        }
+    }
+}
+
+uint64_t Room::msToTicks(int ms) const
+{
+    uint64_t ticks = (static_cast<uint64_t>(ms) * tick_rate + 999) / 1000;
+
+    return ticks > 0 ? ticks : 1;
+}
+
+void Room::enterPhase(Phase next, int duration_ms)
+{
+    phase = next;
+    phase_deadline = current_tick + (duration_ms > 0 ? msToTicks(duration_ms) : 0);
+}
+
+void Room::update()
+{
+    current_tick++;
+
+    switch (phase) {
+        case PHASE_WAITING:
+            if (players.size() >= match_size)
+                enterPhase(PHASE_STARTING, JOIN_GRACE_MS);
+            break;
+
+        case PHASE_STARTING:
+            if (current_tick >= phase_deadline)
+                startCountdown();
+            break;
+
+        case PHASE_COUNTDOWN:
+            if (current_tick >= phase_deadline)
+                advanceCountdown();
+            break;
+
+        case PHASE_RUNNING:
+            checkGameState();
+            break;
+
+        case PHASE_FINISHED:
+            break;
+    }
+}
+
+void Room::broadcast(const SharedPacket &packet)
+{
+    DEBUG_LOG("Room " + std::to_string(room_id) + ": broadcasting message to " +
+              std::to_string(players.size()) + " clients");
+
+    for (size_t slot = 0; slot < players.size(); slot++) {
+        sink.sendToClient(players.getClientFd(slot), packet);
+    }
+}
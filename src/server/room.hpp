@@ -0,0 +1,144 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef ROOM_HPP
+    #define ROOM_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../common/map.hpp"
+#include "../common/packet.hpp"
+#include "../common/packet_io.hpp"
+#include "../common/snapshot.hpp"
+#include "player_table.hpp"
+#include "room_sink.hpp"
+
+// One match: its players, its game state and its broadcast set. The server
+// fills a waiting room until it has enough players, the room then starts
+// and new connections go to a fresh waiting room.
+//
+// The lobby is a state machine driven by update(), each timed phase ends
+// at a deadline counted in ticks, so nothing ever blocks the event loop:
+//   WAITING --full--> STARTING --grace--> COUNTDOWN --3, 2, 1, 0--> RUNNING --> FINISHED
+// A player leaving before RUNNING sends the room back to WAITING.
+class Room {
+public:
+    enum Phase {
+        PHASE_WAITING,      // not enough players yet
+        PHASE_STARTING,     // full, late joiners get their map first
+        PHASE_COUNTDOWN,
+        PHASE_RUNNING,
+        PHASE_FINISHED
+    };
+
+    static const int JOIN_GRACE_MS = 100;
+    static const int COUNTDOWN_FROM = 3;
+    static const int COUNTDOWN_STEP_MS = 500;
+
+private:
+    int room_id;
+    RoomSink &sink;
+    const Map &game_map;
+    size_t match_size;
+    int tick_rate;
+
+    PlayerTable players;
+
+    Phase phase;
+    uint64_t current_tick;
+    uint64_t phase_deadline;
+    int countdown;
+
+    // Snapshots sent to delta-capable clients, kept to diff against the
+    // one each client acknowledged last
+    Snapshot current_snapshot;
+    SnapshotHistory snapshot_history;
+    uint32_t next_sequence;
+
+    // Everything sent during the game is built in pooled buffers, and the
+    // delta and coin run encoding scratch space is reused from one tick to
+    // the next
+    PacketPool packet_pool;
+    std::vector<uint8_t> delta_data;
+    std::vector<uint8_t> coin_data;
+    std::vector<std::pair<uint32_t, SharedPacket>> delta_packets;
+
+    //===========================================================================
+    // Game Logic
+    //===========================================================================
+
+    uint64_t msToTicks(int ms) const;
+
+    void enterPhase(Phase next, int duration_ms);
+
+    void startCountdown();
+
+    void advanceCountdown();
+
+    void startGame();
+
+    void endGame(int winner_fd);
+
+    void initializePlayerPositions();
+
+    void checkGameState();
+
+    void checkGameOverConditions();
+
+    bool checkPlayerCollisions(size_t slot);
+
+    int findSurvivingWinner(size_t dead_slot) const;
+
+    void updateAndSendGameState();
+
+    void addPlayerStateToPacket(PacketWriter &writer, size_t slot);
+
+    SharedPacket buildGameStatePacket();
+
+    void buildSnapshot();
+
+    void sendGameState();
+
+    void notifyCollision(int client_fd, char collision_type, int x, int y);
+
+    void handlePlayerDisconnection();
+
+public:
+    Room(int room_id, RoomSink &sink, const Map &game_map, size_t match_size, int tick_rate);
+
+    Room(const Room &) = delete;
+    Room &operator=(const Room &) = delete;
+
+    int getId() const { return room_id; }
+    size_t getPlayerCount() const { return players.size(); }
+    int getClientFd(size_t slot) const { return players.getClientFd(slot); }
+    Phase getPhase() const { return phase; }
+    bool isStarted() const { return phase == PHASE_RUNNING; }
+    bool isEmpty() const { return players.empty(); }
+    bool isJoinable() const { return phase == PHASE_WAITING && players.size() < match_size; }
+
+    void addPlayer(int client_fd);
+
+    void removePlayer(int client_fd);
+
+    // Called once per simulation tick, runs the lobby phases and the game
+    void update();
+
+    void handlePlayerInput(int client_fd, bool jet_activated);
+
+    void setCapabilities(int client_fd, uint8_t capabilities);
+
+    void handleStateAck(int client_fd, uint32_t sequence);
+
+    // One MSG_COIN_SYNC per player of the room, for a client that lost track
+    void sendCoinSync(int client_fd);
+
+    void broadcast(const SharedPacket &packet);
+};
+
+#endif
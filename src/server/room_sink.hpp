@@ -0,0 +1,25 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef ROOM_SINK_HPP
+    #define ROOM_SINK_HPP
+
+#include "../common/packet.hpp"
+
+// Where a Room sends its packets. The Server queues them on the client
+// sockets, jetpack_sim (src/tools/sim.cpp) only counts them.
+class RoomSink {
+public:
+    virtual ~RoomSink() = default;
+
+    virtual void sendToClient(int client_fd, const SharedPacket &packet) = 0;
+
+    // Droppable data (game state)
+    virtual void sendSnapshot(int client_fd, const SharedPacket &packet) = 0;
+};
+
+#endif
@@ -6,38 +6,38 @@
  */
 
 #include "server.hpp"
-#include "player.hpp"
 #include "../common/debug.hpp"
+#include "../common/messages.hpp"
 #include <iostream>
 #include <cstring>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <fcntl.h>
-#include <algorithm>
+#include <cerrno>
 
 //=============================================================================
 // Constructor & Destructor
 //=============================================================================
 
-Server::Server(int port, const std::string& map_path, bool debug_mode)
-    : server_fd(-1), port(port), map_path(map_path), debug_mode(debug_mode),
-      game_started(false) {
-    g_logger.setDebugMode(debug_mode);
+Server::Server(const ServerConfig &config, const Map &game_map, const MapCache &map_cache,
+               Matchmaker &matchmaker, int shard_id)
+    : server_fd(-1), shard_id(shard_id), config(config), game_map(game_map), map_cache(map_cache),
+      matchmaker(matchmaker), tick_scheduler(config.tick_rate), pending_ticks(0),
+      waiting_room(nullptr), next_room_id(0) {
 }
 
 Server::~Server()
 {
-    for (auto& pair : players) {
-        delete pair.second;
-    }
-    players.clear();
+    rooms.clear();
 
-    for (auto& pfd : poll_fds) {
-        if (pfd.fd >= 0) {
-            close(pfd.fd);
-        }
+    for (auto& pair : connections) {
+        close(pair.first);
     }
+    connections.clear();
+
+    if (server_fd >= 0)
+        close(server_fd);
 }
 
 //=============================================================================
@@ -46,24 +46,9 @@ Server::~Server()
 
 bool Server::initialize()
 {
-    if (!loadGameMap())
-        return false;
-
     return initializeServer();
 }
 
-bool Server::loadGameMap()
-{
-    if (!game_map.loadFromFile(map_path)) {
-        std::cerr << "T as chie la map mon reuf: " << map_path << std::endl;
-        return false;
-    }
-
-    DEBUG_LOG("Map loaded successfully: " + std::to_string(game_map.getWidth()) +
-              "x" + std::to_string(game_map.getHeight()));
-    return true;
-}
-
 bool Server::initializeServer()
 {
     server_fd = socket(AF_INET, SOCK_STREAM, 0);
@@ -76,24 +61,36 @@ bool Server::initializeServer()
 
     if (!setSocketOptions()) {
         close(server_fd);
+        server_fd = -1;
         return false;
     }
 
     if (!bindSocket()) {
         close(server_fd);
+        server_fd = -1;
+        return false;
+    }
+
+    if (listen(server_fd, SOMAXCONN) < 0) {
+        close(server_fd);
+        server_fd = -1;
         return false;
     }
 
-    if (listen(server_fd, 5) < 0) {
+    if (!reactor.initialize() || !reactor.add(server_fd, EPOLLIN) ||
+        !tick_scheduler.initialize() || !reactor.add(tick_scheduler.getFd(), EPOLLIN) ||
+        !reactor.add(matchmaker.getEventFd(shard_id), EPOLLIN)) {
         close(server_fd);
+        server_fd = -1;
         return false;
     }
 
-    pollfd pfd = {server_fd, POLLIN, 0};
-    poll_fds.push_back(pfd);
+    // UDP is optional, without it everything keeps going over TCP
+    if (config.udp_enabled &&
+        (!udp_channel.initialize() || !reactor.add(udp_channel.getFd(), EPOLLIN)))
+        std::cerr << "UDP channel unavailable, game state stays on TCP." << std::endl;
 
-    std::cout << "Port is: " << port << std::endl;
-    DEBUG_LOG("Debug mode is " + std::string(debug_mode ? "Here" : "Not here"));
+    DEBUG_LOG("Shard " + std::to_string(shard_id) + " listening on port " + std::to_string(config.port));
 
     return true;
 }
@@ -104,6 +101,10 @@ bool Server::setSocketOptions()
 
     if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0)
         return false;
+
+    // Every worker binds its own listener on the same port
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0)
+        return false;
     return true;
 }
 
@@ -113,7 +114,7 @@ bool Server::bindSocket()
     memset(&address, 0, sizeof(address));
     address.sin_family = AF_INET;
     address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(port);
+    address.sin_port = htons(config.port);
 
     if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0)
         return false;
@@ -132,117 +133,408 @@ void Server::setNonBlocking(int fd)
 
 void Server::run()
 {
+    // No timeout: the tick timerfd wakes us up at the tick rate anyway
     while (true) {
-        int poll_count = poll(poll_fds.data(), poll_fds.size(), 100);
-
-        if (poll_count < 0)
+        if (reactor.wait(-1) < 0) {
+            if (errno == EINTR)
+                continue;
             break;
+        }
 
         processSocketEvents();
 
-        updateGameState();
+        sendOverdueMaps();
+
+        runPendingTicks();
+
+        flushPendingWrites();
+
+        evictSlowClients();
+        reapClosedClients();
     }
 }
 
 void Server::processSocketEvents()
 {
-    for (size_t i = 0; i < poll_fds.size(); i++) {
-        if (poll_fds[i].revents == 0)
-            continue;
+    int ready_count = reactor.getReadyCount();
+
+    for (int i = 0; i < ready_count; i++) {
+        int fd = reactor.getReadyFd(i);
+        uint32_t events = reactor.getReadyEvents(i);
 
-        if (poll_fds[i].fd == server_fd && (poll_fds[i].revents & POLLIN)) {
+        if (fd == server_fd) {
             acceptNewClient();
             continue;
         }
 
-        if (poll_fds[i].revents & POLLIN)
-            handleClientData(poll_fds[i].fd);
+        // Ticks run once the whole I/O batch is handled, so inputs that
+        // arrived together with the timer are applied to this tick
+        if (fd == tick_scheduler.getFd()) {
+            pending_ticks += tick_scheduler.collectDueTicks();
+            continue;
+        }
+
+        if (fd == udp_channel.getFd()) {
+            handleUdpData();
+            continue;
+        }
 
-        if (poll_fds[i].revents & (POLLHUP | POLLERR))
-            removeClient(poll_fds[i].fd);
+        if (fd == matchmaker.getEventFd(shard_id)) {
+            adoptHandoffs();
+            continue;
+        }
+
+        handleClientEvents(fd, events);
+    }
+}
+
+void Server::handleClientEvents(int client_fd, uint32_t events)
+{
+    auto it = connections.find(client_fd);
+
+    if (it == connections.end() || it->second.closing)
+        return;
+
+    if (events & EPOLLOUT)
+        flushClient(it->second);
+
+    // Read first: a peer that sent its last input and hung up still gets
+    // that input processed before we drop it.
+    if (events & (EPOLLIN | EPOLLRDHUP))
+        handleClientData(client_fd);
+
+    it = connections.find(client_fd);
+
+    if ((events & (EPOLLHUP | EPOLLERR)) && it != connections.end() && !it->second.closing)
+        removeClient(client_fd);
+}
+
+void Server::runPendingTicks()
+{
+    const TickStats &stats = tick_scheduler.getStats();
+    uint64_t report_every = static_cast<uint64_t>(tick_scheduler.getTickRate()) * 10;
+
+    while (pending_ticks > 0) {
+        auto start = std::chrono::steady_clock::now();
+
+        updateGameState();
+
+        tick_scheduler.recordTick(std::chrono::steady_clock::now() - start);
+        pending_ticks--;
+
+        // Only the tick that reaches the boundary reports, not every wakeup until the next one
+        if (stats.ticks_run % report_every == 0)
+            DEBUG_LOG("Tick stats: " + tick_scheduler.formatStats());
     }
 }
 
 void Server::updateGameState()
 {
-    if (game_started) {
-        checkGameState();
+    for (auto it = rooms.begin(); it != rooms.end(); ) {
+        Room *room = it->second.get();
+
+        room->update();
+
+        if (room == waiting_room && !room->isJoinable())
+            waiting_room = nullptr;
+        else if (room != waiting_room && room->isJoinable() && !room->isEmpty())
+            stranded_rooms.push_back(room); // its countdown was cancelled
+
+        if (room->isEmpty() && room != waiting_room) {
+            DEBUG_LOG("Closing empty room " + std::to_string(room->getId()));
+            it = rooms.erase(it);
+        } else {
+            it++;
+        }
     }
-    else if (players.size() >= 2 && !game_started) {
-        startGame();
+
+    for (Room *room : stranded_rooms)
+        rehomeStrandedRoom(room);
+    stranded_rooms.clear();
+}
+
+void Server::rehomeStrandedRoom(Room *room)
+{
+    std::vector<int> client_fds;
+
+    for (size_t slot = 0; slot < room->getPlayerCount(); slot++)
+        client_fds.push_back(room->getClientFd(slot));
+
+    for (int client_fd : client_fds) {
+        int shard = matchmaker.claim(shard_id);
+
+        if (shard != shard_id) {
+            // Tried again next tick if the connection is busy
+            handOffClient(client_fd, shard);
+            continue;
+        }
+
+        // Nobody else is waiting: new players come to this room again
+        if (!waiting_room || !waiting_room->isJoinable() || waiting_room->isEmpty()) {
+            waiting_room = room;
+            return;
+        }
+
+        moveToWaitingRoom(client_fd, room);
     }
 }
 
+void Server::moveToWaitingRoom(int client_fd, Room *room)
+{
+    auto it = connections.find(client_fd);
+
+    if (it == connections.end() || it->second.closing)
+        return;
+
+    room->removePlayer(client_fd);
+    waiting_room->addPlayer(client_fd);
+    waiting_room->setCapabilities(client_fd, it->second.capabilities);
+    client_rooms[client_fd] = waiting_room;
+
+    if (!waiting_room->isJoinable())
+        matchmaker.release(shard_id);
+}
+
+bool Server::handOffClient(int client_fd, int shard)
+{
+    auto it = connections.find(client_fd);
+
+    if (it == connections.end() || it->second.closing)
+        return false;
+
+    Connection &connection = it->second;
+
+    // Only between two messages, with the map out: the other shard starts
+    // from an empty reader and an empty send queue
+    if (connection.outbound.size() > 0 || connection.reader.buffered() > 0 ||
+        connection.next_map_chunk < connection.map_chunk_count)
+        return false;
+
+    Matchmaker::Handoff handoff = { client_fd, connection.capabilities, connection.map_sent };
+
+    detachClient(client_fd);
+    matchmaker.handOff(shard, handoff);
+
+    DEBUG_LOG("Client " + std::to_string(client_fd) + " moved to shard " + std::to_string(shard));
+    return true;
+}
+
 //=============================================================================
 // Client Connection Management
 //=============================================================================
 
 void Server::acceptNewClient()
 {
-    struct sockaddr_in address;
-    socklen_t addrlen = sizeof(address);
-    int client_fd = accept(server_fd, (struct sockaddr *)&address, &addrlen);
+    // Edge-triggered listener: keep accepting until the backlog is empty
+    while (true) {
+        struct sockaddr_in address;
+        socklen_t addrlen = sizeof(address);
+        int client_fd = accept4(server_fd, (struct sockaddr *)&address, &addrlen,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (client_fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                DEBUG_LOG("accept failed, errno=" + std::to_string(errno));
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+
+        placeClient({ client_fd, 0, false });
+    }
+}
+
+void Server::placeClient(const Matchmaker::Handoff &handoff)
+{
+    int shard = matchmaker.claim(shard_id);
+
+    if (shard != shard_id) {
+        matchmaker.handOff(shard, handoff);
+        return;
+    }
 
-    if (client_fd < 0)
+    // Data that arrived before this shard took the socket is reported
+    // by the first wait()
+    if (!reactor.add(handoff.fd, EPOLLIN | EPOLLRDHUP)) {
+        close(handoff.fd);
         return;
+    }
+
+    registerClient(handoff);
+}
+
+void Server::adoptHandoffs()
+{
+    matchmaker.collect(shard_id, handoffs);
 
-    setNonBlocking(client_fd);
+    // The open room may have moved on meanwhile, placing again forwards them
+    for (const Matchmaker::Handoff &handoff : handoffs)
+        placeClient(handoff);
+}
 
-    pollfd pfd = {client_fd, POLLIN, 0};
-    poll_fds.push_back(pfd);
-    players[client_fd] = new Player(client_fd);
+void Server::registerClient(const Matchmaker::Handoff &handoff)
+{
+    int client_fd = handoff.fd;
+    Connection &connection = connections.try_emplace(client_fd, client_fd).first->second;
+
+    Room *room = findWaitingRoom();
+    room->addPlayer(client_fd);
+    client_rooms[client_fd] = room;
+
+    if (handoff.connected) {
+        // Moved from another shard after getting its map, only its UDP
+        // channel has to be set up again
+        connection.capabilities = handoff.capabilities;
+        connection.map_sent = true;
+        room->setCapabilities(client_fd, handoff.capabilities);
+
+        if ((handoff.capabilities & CAP_UDP) && udp_channel.getFd() >= 0)
+            offerUdpChannel(client_fd);
+    } else {
+        awaiting_connect.emplace_back(client_fd, connection.registered_at);
+        std::cout << "New client: " << client_fd << std::endl;
+    }
 
-    std::cout << "New client: " << client_fd << std::endl;
-    DEBUG_LOG("Client connected: fd=" + std::to_string(client_fd));
+    DEBUG_LOG("Client connected: fd=" + std::to_string(client_fd) +
+              ", shard=" + std::to_string(shard_id) + ", room=" + std::to_string(room->getId()));
 
-    sendMapToClient(client_fd);
+    if (!room->isJoinable())
+        matchmaker.release(shard_id);
+}
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+Room *Server::findWaitingRoom()
+{
+    if (waiting_room && waiting_room->isJoinable())
+        return waiting_room;
 
-    if (game_started) {
-        DEBUG_LOG("Game already started, you gotta wait buddy: " + std::to_string(client_fd));
-        removeClient(client_fd);
+    int room_id = next_room_id++;
+    auto room = std::make_unique<Room>(room_id, *this, game_map, config.players_per_match,
+                                       config.tick_rate);
+
+    waiting_room = room.get();
+    rooms[room_id] = std::move(room);
+
+    DEBUG_LOG("Opened waiting room " + std::to_string(room_id));
+    return waiting_room;
+}
+
+void Server::sendMapToClient(int client_fd, uint8_t capabilities)
+{
+    auto it = connections.find(client_fd);
+
+    if (it == connections.end() || it->second.map_sent)
+        return;
+
+    Connection &connection = it->second;
+
+    connection.map_sent = true;
+
+    if (capabilities & CAP_MAP_CHUNKS) {
+        connection.map_chunk_count = map_cache.getChunkCount();
+        queueMapPacket(connection, map_cache.getInfo());
+        queueMapChunks(connection);
+        return;
+    }
+
+    // Older clients only know MSG_MAP_DATA, which cannot carry it all
+    if (!map_cache.hasFullMap()) {
+        std::cerr << "Map too big for client " << client_fd << " without chunked transfer" << std::endl;
+        scheduleRemoval(client_fd);
+        return;
+    }
+
+    queueMapPacket(connection, map_cache.getFullMap());
+}
+
+void Server::sendOverdueMaps()
+{
+    auto deadline = std::chrono::steady_clock::now() - std::chrono::milliseconds(CONNECT_TIMEOUT_MS);
+
+    while (!awaiting_connect.empty() && awaiting_connect.front().second <= deadline) {
+        auto [client_fd, registered_at] = awaiting_connect.front();
+        auto it = connections.find(client_fd);
+
+        awaiting_connect.pop_front();
+
+        // Gone, or the fd now belongs to a newer connection
+        if (it == connections.end() || it->second.registered_at != registered_at || it->second.map_sent)
+            continue;
+
+        DEBUG_LOG("No MSG_CONNECT from client " + std::to_string(client_fd) + ", sending MSG_MAP_DATA");
+        sendMapToClient(client_fd, 0);
     }
 }
 
-void Server::sendMapToClient(int client_fd)
+void Server::queueMapPacket(Connection &connection, const MapCache::Entry &entry)
 {
-    std::vector<uint8_t> map_data = game_map.serialize();
-    std::vector<uint8_t> packet = Protocol::createPacket(MSG_MAP_DATA, map_data);
+    if (map_cache.getFd() >= 0)
+        connection.outbound.pushFile(map_cache.getFd(), entry.offset, entry.length);
+    else
+        connection.outbound.push(map_cache.slice(entry));
 
-    sendToClient(client_fd, packet);
+    scheduleFlush(connection);
+}
+
+bool Server::queueMapChunks(Connection &connection)
+{
+    bool queued = false;
+
+    while (connection.next_map_chunk < connection.map_chunk_count &&
+           connection.outbound.size() < config.send_low_watermark) {
+        queueMapPacket(connection, map_cache.getChunk(connection.next_map_chunk++));
+        queued = true;
+    }
+    return queued;
 }
 
 void Server::removeClient(int client_fd)
 {
+    detachClient(client_fd);
     close(client_fd);
 
-    auto it = std::find_if(poll_fds.begin(), poll_fds.end(),
-                          [client_fd](const pollfd& pfd) { return pfd.fd == client_fd; });
+    DEBUG_LOG("Client removed: " + std::to_string(client_fd));
+}
+
+void Server::detachClient(int client_fd)
+{
+    reactor.remove(client_fd);
 
-    if (it != poll_fds.end())
-        poll_fds.erase(it);
+    connections.erase(client_fd);
+    congested_clients.erase(client_fd);
+    udp_channel.forget(client_fd);
 
-    auto player_it = players.find(client_fd);
+    auto room_it = client_rooms.find(client_fd);
 
-    if (player_it != players.end()) {
-        delete player_it->second;
-        players.erase(player_it);
+    if (room_it != client_rooms.end()) {
+        Room *room = room_it->second;
+
+        client_rooms.erase(room_it);
+        room->removePlayer(client_fd);
     }
+}
 
-    handlePlayerDisconnection();
+void Server::scheduleRemoval(int client_fd)
+{
+    auto it = connections.find(client_fd);
 
-    DEBUG_LOG("Client removed: " + std::to_string(client_fd));
+    if (it == connections.end() || it->second.closing)
+        return;
+
+    // Removal is deferred so callers iterating players/connections
+    // (broadcasts mostly) never see their container change under them
+    it->second.closing = true;
+    pending_removals.push_back(client_fd);
 }
 
-void Server::handlePlayerDisconnection()
+void Server::reapClosedClients()
 {
-    if (game_started && players.size() < 2) {
-        if (players.size() == 1) {
-            endGame(players.begin()->first);
-        } else {
-            game_started = false;
-        }
+    std::vector<int> removals;
+
+    removals.swap(pending_removals);
+
+    for (int client_fd : removals) {
+        if (connections.count(client_fd))
+            removeClient(client_fd);
     }
 }
 
@@ -252,85 +544,215 @@ void Server::handlePlayerDisconnection()
 
 void Server::handleClientData(int client_fd)
 {
-    memset(recv_buffer, 0, BUFFER_SIZE);
+    // Edge-triggered: drain the socket, we will not be woken up again
+    // for data that is already queued. Every read is followed by a batch
+    // dispatch of all the complete messages it made available.
+    auto it = connections.find(client_fd);
+
+    while (it != connections.end() && !it->second.closing) {
+        ssize_t bytes_read = it->second.reader.readFrom(client_fd);
+
+        if (bytes_read <= 0) {
+            if (handleReceiveError(client_fd, bytes_read))
+                continue;
+            return;
+        }
 
-    ssize_t bytes_read = recv(client_fd, recv_buffer, BUFFER_SIZE, 0);
+        if (!dispatchFrames(it->second)) {
+            DEBUG_LOG("Protocol error, dropping client: " + std::to_string(client_fd));
+            removeClient(client_fd);
+            return;
+        }
 
-    if (bytes_read <= 0) {
-        handleReceiveError(client_fd, bytes_read);
-        return;
+        it = connections.find(client_fd);
     }
+}
 
-    DEBUG_PACKET_RECV(recv_buffer, bytes_read);
+bool Server::dispatchFrames(Connection &connection)
+{
+    int client_fd = connection.fd;
+    FrameReader::Frame frame;
+    FrameReader::Result result;
 
-    processClientMessage(client_fd, bytes_read);
-}
+    while ((result = connection.reader.next(frame)) == FrameReader::FRAME_READY) {
+        DEBUG_PACKET_RECV(reinterpret_cast<const char*>(frame.payload), frame.size);
 
+        processClientMessage(client_fd, frame);
 
-void Server::handleReceiveError(int client_fd, ssize_t bytes_read)
+        if (!connections.count(client_fd) || connection.closing)
+            return true;
+    }
+    return result == FrameReader::NEED_MORE_DATA;
+}
+
+bool Server::handleReceiveError(int client_fd, ssize_t bytes_read)
 {
+    if (bytes_read < 0 && errno == EINTR)
+        return true;
+
+    if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return false;
+
     if (bytes_read == 0) {
         DEBUG_LOG("Client disconnected: " + std::to_string(client_fd));
-        removeClient(client_fd);
     } else {
         DEBUG_LOG("Error reading from client: " + std::to_string(client_fd) +
                 ", errno=" + std::to_string(errno));
     }
+    removeClient(client_fd);
+    return false;
 }
 
-bool Server::parseMessageHeader(int client_fd, ssize_t bytes_read, MessageHeader& header)
+void Server::handleConnectMessage(int client_fd, const FrameReader::Frame &frame)
 {
-    if (!Protocol::parseHeader(recv_buffer, bytes_read, header))
-        return false;
+    // An empty payload is an older client without capabilities
+    ConnectMessage connect = {};
 
-    uint32_t payload_size = Protocol::getPayloadSize(header);
+    ConnectSchema::decode(frame.payload, frame.size, connect);
 
-    if (bytes_read < sizeof(MessageHeader) + payload_size)
-        return false;
+    uint8_t capabilities = connect.capabilities;
 
-    return true;
+    DEBUG_LOG("Client " + std::to_string(client_fd) + " sent connect message, capabilities=" +
+              std::to_string(capabilities));
+
+    auto connection_it = connections.find(client_fd);
+
+    if (connection_it != connections.end())
+        connection_it->second.capabilities = capabilities;
+
+    auto room_it = client_rooms.find(client_fd);
+
+    if (room_it != client_rooms.end())
+        room_it->second->setCapabilities(client_fd, capabilities);
+
+    sendMapToClient(client_fd, capabilities);
+
+    if ((capabilities & CAP_UDP) && udp_channel.getFd() >= 0)
+        offerUdpChannel(client_fd);
 }
 
-void Server::handleConnectMessage(int client_fd)
+void Server::offerUdpChannel(int client_fd)
 {
-    DEBUG_LOG("Client " + std::to_string(client_fd) + " sent connect message");
+    uint32_t token = udp_channel.offer(client_fd);
+    uint16_t udp_port = udp_channel.getPort();
+
+    auto packet = UdpOfferSchema::packet({ udp_port, token });
+
+    sendToClient(client_fd, SharedPacket(std::vector<uint8_t>(packet.begin(), packet.end())));
 }
 
-void Server::handlePlayerInputMessage(int client_fd, const MessageHeader &header)
+void Server::handleUdpData()
 {
-    uint32_t payload_size = Protocol::getPayloadSize(header);
+    UdpChannel::Datagram datagram;
+
+    // Edge-triggered like everything else: read until the socket is empty
+    while (udp_channel.receive(datagram)) {
+        int client_fd = datagram.client_fd;
+        auto it = connections.find(client_fd);
+
+        if (it == connections.end() || it->second.closing)
+            continue;
+
+        if (datagram.just_activated) {
+            DEBUG_LOG("UDP channel up for client " + std::to_string(client_fd));
+            sendToClient(client_fd, Protocol::createSharedPacket(MSG_UDP_READY, {}));
+        }
+
+        size_t pos = 0;
 
-    if (payload_size >= 1) {
-        bool jet_activated = (recv_buffer[sizeof(MessageHeader)] != 0);
-        handlePlayerInput(client_fd, jet_activated);
+        while (pos + sizeof(MessageHeader) <= datagram.size) {
+            FrameReader::Frame frame;
 
-        logPlayerInput(client_fd, jet_activated);
+            memcpy(&frame.header, datagram.messages + pos, sizeof(MessageHeader));
+            frame.size = Protocol::getPayloadSize(frame.header);
+            frame.payload = datagram.messages + pos + sizeof(MessageHeader);
+            pos += sizeof(MessageHeader) + frame.size;
+
+            if (pos > datagram.size)
+                break;
+
+            processUdpMessage(client_fd, frame);
+        }
     }
 }
 
-void Server::logPlayerInput(int client_fd, bool jet_activated)
+void Server::processUdpMessage(int client_fd, const FrameReader::Frame &frame)
 {
-    auto player_it = players.find(client_fd);
-    if (player_it != players.end()) {
-        DEBUG_LOG("Player " + std::to_string(player_it->second->getPlayerNumber()) +
-                 " input processed: jet " + (jet_activated ? "ON" : "OFF"));
+    // Only the droppable messages are accepted on the UDP channel
+    switch (frame.header.type) {
+        case MSG_PLAYER_INPUT:
+            handlePlayerInputMessage(client_fd, frame);
+            break;
+
+        case MSG_STATE_ACK:
+            handleStateAckMessage(client_fd, frame);
+            break;
+
+        default:
+            break;
     }
 }
 
-void Server::processClientMessage(int client_fd, ssize_t bytes_read)
+void Server::handleStateAckMessage(int client_fd, const FrameReader::Frame &frame)
 {
-    MessageHeader header;
-    if (!parseMessageHeader(client_fd, bytes_read, header)) {
+    StateAckMessage ack;
+
+    if (!StateAckSchema::decode(frame.payload, frame.size, ack))
         return;
-    }
 
-    switch (header.type) {
+    auto room_it = client_rooms.find(client_fd);
+
+    if (room_it != client_rooms.end())
+        room_it->second->handleStateAck(client_fd, ack.sequence);
+}
+
+void Server::handlePlayerInputMessage(int client_fd, const FrameReader::Frame &frame)
+{
+    PlayerInputMessage input;
+
+    if (!PlayerInputSchema::decode(frame.payload, frame.size, input))
+        return;
+
+    auto room_it = client_rooms.find(client_fd);
+
+    if (room_it != client_rooms.end())
+        room_it->second->handlePlayerInput(client_fd, input.jet_active);
+}
+
+void Server::handleCoinSyncMessage(int client_fd)
+{
+    auto it = connections.find(client_fd);
+
+    // The answer holds the coin runs of every player, a client asking
+    // again and again only gets ignored
+    if (it == connections.end() || it->second.coin_sync_sent)
+        return;
+
+    it->second.coin_sync_sent = true;
+
+    auto room_it = client_rooms.find(client_fd);
+
+    if (room_it != client_rooms.end())
+        room_it->second->sendCoinSync(client_fd);
+}
+
+void Server::processClientMessage(int client_fd, const FrameReader::Frame &frame)
+{
+    switch (frame.header.type) {
         case MSG_CONNECT:
-            handleConnectMessage(client_fd);
+            handleConnectMessage(client_fd, frame);
+            break;
+
+        case MSG_STATE_ACK:
+            handleStateAckMessage(client_fd, frame);
             break;
 
         case MSG_PLAYER_INPUT:
-            handlePlayerInputMessage(client_fd, header);
+            handlePlayerInputMessage(client_fd, frame);
+            break;
+
+        case MSG_COIN_SYNC:
+            handleCoinSyncMessage(client_fd);
             break;
 
         default:
@@ -342,38 +764,115 @@ void Server::processClientMessage(int client_fd, ssize_t bytes_read)
 // Network Communication
 //=============================================================================
 
-void Server::sendToClient(int client_fd, const std::vector<uint8_t> &data)
+void Server::sendToClient(int client_fd, const SharedPacket &packet)
 {
-    if (data.empty()) {
+    auto it = connections.find(client_fd);
+
+    if (packet.empty() || it == connections.end() || it->second.closing)
         return;
+
+    Connection &connection = it->second;
+
+    connection.outbound.push(packet);
+    scheduleFlush(connection);
+    updateBackpressure(connection);
+}
+
+void Server::scheduleFlush(Connection &connection)
+{
+    // With EPOLLOUT armed the reactor flushes it as soon as there is room
+    if (!connection.write_armed && !connection.flush_scheduled) {
+        connection.flush_scheduled = true;
+        dirty_clients.push_back(connection.fd);
+    }
+}
+
+void Server::sendSnapshot(int client_fd, const SharedPacket &packet)
+{
+    if (!udp_channel.send(client_fd, packet))
+        sendToClient(client_fd, packet);
+}
+
+void Server::flushPendingWrites()
+{
+    // Both lists keep their capacity, flushing does not allocate
+    flushing_clients.swap(dirty_clients);
+
+    for (int client_fd : flushing_clients) {
+        auto it = connections.find(client_fd);
+
+        if (it == connections.end())
+            continue;
+
+        it->second.flush_scheduled = false;
+
+        if (!it->second.closing)
+            flushClient(it->second);
     }
+    flushing_clients.clear();
+}
+
+void Server::flushClient(Connection &connection)
+{
+    OutboundQueue::FlushResult result = connection.outbound.flush(connection.fd);
 
-    ssize_t bytes_sent = send(client_fd, data.data(), data.size(), 0);
+    // A large map streams out as the socket drains instead of sitting in memory
+    while (result == OutboundQueue::FLUSH_DONE && queueMapChunks(connection))
+        result = connection.outbound.flush(connection.fd);
 
-    if (bytes_sent < 0) {
-        std::cerr << "Cannot send data to client: " << client_fd << std::endl;
-        DEBUG_LOG("Failed to send data to client: " + std::to_string(client_fd) +
-                  ", errno=" + std::to_string(errno));
+    if (result == OutboundQueue::FLUSH_ERROR) {
+        std::cerr << "Cannot send data to client: " << connection.fd << std::endl;
+        scheduleRemoval(connection.fd);
         return;
     }
 
-    DEBUG_PACKET_SEND(reinterpret_cast<const char*>(data.data()), bytes_sent);
+    bool want_write = (result == OutboundQueue::FLUSH_PENDING);
+
+    if (want_write != connection.write_armed) {
+        uint32_t events = EPOLLIN | EPOLLRDHUP;
+
+        if (want_write)
+            events |= EPOLLOUT;
+
+        if (reactor.modify(connection.fd, events))
+            connection.write_armed = want_write;
+    }
+
+    updateBackpressure(connection);
+}
+
+void Server::updateBackpressure(Connection &connection)
+{
+    size_t queued = connection.outbound.size();
+
+    if (!connection.congested && queued > config.send_high_watermark) {
+        connection.congested = true;
+        connection.congested_since = std::chrono::steady_clock::now();
+        congested_clients.insert(connection.fd);
+        DEBUG_LOG("Client " + std::to_string(connection.fd) + " is lagging: " +
+                  std::to_string(queued) + " bytes queued");
+    } else if (connection.congested && queued <= config.send_low_watermark) {
+        connection.congested = false;
+        congested_clients.erase(connection.fd);
+        DEBUG_LOG("Client " + std::to_string(connection.fd) + " caught up");
+    }
 }
 
- void Server::broadcastToAllClients(const std::vector<uint8_t>& data)
- {
-     DEBUG_LOG("Broadcasting message to " + std::to_string(players.size()) + " clients");
+void Server::evictSlowClients()
+{
+    if (congested_clients.empty())
+        return;
+
+    auto now = std::chrono::steady_clock::now();
+    auto timeout = std::chrono::milliseconds(config.slow_client_timeout_ms);
 
-     for (auto& pair : players) {
-         int client_fd = pair.first;
-         ssize_t sent = send(client_fd, data.data(), data.size(), 0);
+    for (int client_fd : congested_clients) {
+        const Connection &connection = connections.at(client_fd);
+
+        if (!connection.closing && now - connection.congested_since > timeout) {
+            std::cerr << "Kicking slow client: " << client_fd << std::endl;
+            scheduleRemoval(client_fd);
+        }
+    }
+}
 
-         if (sent < 0) {
-             DEBUG_LOG("CAnnot broadcast to client: " + std::to_string(client_fd) +
-                       ", errno=" + std::to_string(errno));
-         } else {
-             DEBUG_LOG("Ca broadcast " + std::to_string(sent) +
-                       " bytes to client: " + std::to_string(client_fd));
-         }
-     }
- }
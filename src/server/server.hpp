@@ -11,30 +11,88 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include <thread>
 #include <chrono>
-#include <poll.h>
 #include <netinet/in.h>
 #include "../common/map.hpp"
 #include "../common/protocol.hpp"
+#include "reactor.hpp"
+#include "connection.hpp"
+#include "tick_scheduler.hpp"
+#include "room.hpp"
+#include "udp_channel.hpp"
+#include "map_cache.hpp"
+#include "matchmaker.hpp"
+
+struct ServerConfig {
+    int port = -1;
+    std::string map_path;
+    bool debug_mode = false;
 
-class Player;
+    // Outbound backpressure: a client whose queue stays above the high
+    // watermark for longer than slow_client_timeout_ms is disconnected
+    size_t send_high_watermark = 256 * 1024;
+    size_t send_low_watermark = 64 * 1024;
+    int slow_client_timeout_ms = 2000;
 
-class Server {
-private:
-    int server_fd;
-    int port;
-    std::string map_path;
-    bool debug_mode;
+    int tick_rate = TickScheduler::DEFAULT_TICK_RATE;
 
-    Map game_map;
-    bool game_started;
+    size_t players_per_match = 2;
 
-    std::vector<pollfd> poll_fds;
-    std::map<int, Player*> players;
+    // Each worker runs its own Server (listener, reactor, rooms) on its own
+    // thread, the kernel spreads connections between them with SO_REUSEPORT
+    int worker_threads = 1;
+    bool pin_threads = false;
 
-    static const size_t BUFFER_SIZE = 1024;
-    char recv_buffer[BUFFER_SIZE];
+    // Offer clients with CAP_UDP a datagram channel for game state
+    bool udp_enabled = false;
+};
+
+// One shard of the server. Nothing in here is shared with the other
+// workers except the read-only map and the matchmaker, so the tick path
+// takes no locks.
+class Server : public RoomSink {
+public:
+    // Clients older than MSG_CONNECT never send it, they get the map once
+    // this long after they connected
+    static constexpr int CONNECT_TIMEOUT_MS = 500;
+
+private:
+    int server_fd;
+    int shard_id;
+    ServerConfig config;
+
+    const Map &game_map;
+    const MapCache &map_cache;
+    Matchmaker &matchmaker;
+
+    Reactor reactor;
+    TickScheduler tick_scheduler;
+    uint32_t pending_ticks;
+    UdpChannel udp_channel;
+    std::unordered_map<int, Connection> connections;
+    std::unordered_set<int> congested_clients;
+    std::vector<int> pending_removals;
+    std::vector<int> dirty_clients;
+    std::vector<int> flushing_clients;
+
+    // Registered clients that did not send MSG_CONNECT yet, oldest first
+    std::deque<std::pair<int, std::chrono::steady_clock::time_point>> awaiting_connect;
+
+    // Rooms by id, and the room each connected client belongs to
+    std::map<int, std::unique_ptr<Room>> rooms;
+    std::unordered_map<int, Room*> client_rooms;
+    Room *waiting_room;
+    int next_room_id;
+
+    // Connections handed over by other shards, and rooms whose countdown
+    // was cancelled while another room was taking new players
+    std::vector<Matchmaker::Handoff> handoffs;
+    std::vector<Room *> stranded_rooms;
 
     //===========================================================================
     // Server Initialization
@@ -42,8 +100,6 @@ private:
 
     bool initializeServer();
 
-    bool loadGameMap();
-
     bool setSocketOptions();
 
     bool bindSocket();
@@ -56,11 +112,42 @@ private:
 
     void acceptNewClient();
 
-    void sendMapToClient(int client_fd);
+    // Registers the client here if this shard has the open waiting room,
+    // hands it over to the shard that has it otherwise
+    void placeClient(const Matchmaker::Handoff &handoff);
+
+    void adoptHandoffs();
+
+    void registerClient(const Matchmaker::Handoff &handoff);
+
+    void sendMapToClient(int client_fd, uint8_t capabilities);
+
+    void sendOverdueMaps();
+
+    // Queues map chunks until outbound reaches the low watermark,
+    // false when there was nothing left to queue
+    bool queueMapChunks(Connection &connection);
+
+    void queueMapPacket(Connection &connection, const MapCache::Entry &entry);
 
     void removeClient(int client_fd);
 
-    void handlePlayerDisconnection();
+    // Forgets the client without closing its socket
+    void detachClient(int client_fd);
+
+    Room *findWaitingRoom();
+
+    // Brings the players of a stranded room to the open waiting room
+    void rehomeStrandedRoom(Room *room);
+
+    void moveToWaitingRoom(int client_fd, Room *room);
+
+    // false while the connection is busy (map transfer, partial message)
+    bool handOffClient(int client_fd, int shard);
+
+    void scheduleRemoval(int client_fd);
+
+    void reapClosedClients();
 
     //===========================================================================
     // Client Data Handling
@@ -68,17 +155,25 @@ private:
 
     void handleClientData(int client_fd);
 
-    void handleReceiveError(int client_fd, ssize_t bytes_read);
+    bool handleReceiveError(int client_fd, ssize_t bytes_read);
+
+    bool dispatchFrames(Connection &connection);
+
+    void handleConnectMessage(int client_fd, const FrameReader::Frame &frame);
+
+    void handleStateAckMessage(int client_fd, const FrameReader::Frame &frame);
+
+    void offerUdpChannel(int client_fd);
 
-    bool parseMessageHeader(int client_fd, ssize_t bytes_read, MessageHeader &header);
+    void handleUdpData();
 
-    void handleConnectMessage(int client_fd);
+    void processUdpMessage(int client_fd, const FrameReader::Frame &frame);
 
-    void handlePlayerInputMessage(int client_fd, const MessageHeader &header);
+    void handlePlayerInputMessage(int client_fd, const FrameReader::Frame &frame);
 
-    void logPlayerInput(int client_fd, bool jet_activated);
+    void handleCoinSyncMessage(int client_fd);
 
-    void processClientMessage(int client_fd, ssize_t bytes_read);
+    void processClientMessage(int client_fd, const FrameReader::Frame &frame);
 
     //===========================================================================
     // Socket Event Processing
@@ -86,36 +181,29 @@ private:
 
     void processSocketEvents();
 
-    void updateGameState();
-
-    //===========================================================================
-    // Network Communication
-    //===========================================================================
+    void handleClientEvents(int client_fd, uint32_t events);
 
-    void sendToClient(int client_fd, const std::vector<uint8_t> &data);
+    void runPendingTicks();
 
-    void broadcastToAllClients(const std::vector<uint8_t> &data);
+    void updateGameState();
 
     //===========================================================================
-    // Game Logic
+    // Network Communication
     //===========================================================================
 
-    void initializePlayerPositions();
-
-    void checkGameState();
-
-    void checkGameOverConditions();
+    void flushClient(Connection &connection);
 
-    void constrainPlayerToMap(Player *player);
+    void scheduleFlush(Connection &connection);
 
-    bool checkPlayerCollisions(int client_fd, Player *player);
+    void flushPendingWrites();
 
-    void updateAndSendGameState();
+    void updateBackpressure(Connection &connection);
 
-    void addPlayerStateToPacket(std::vector<uint8_t> &data, Player *player);
+    void evictSlowClients();
 
 public:
-    Server(int port, const std::string& map_path, bool debug_mode);
+    Server(const ServerConfig &config, const Map &game_map, const MapCache &map_cache,
+           Matchmaker &matchmaker, int shard_id = 0);
 
     ~Server();
 
@@ -123,17 +211,20 @@ public:
 
     void run();
 
-    Map &getMap()
+    const Map &getMap() const
     {
         return game_map;
     }
 
-    void handlePlayerInput(int client_fd, bool jet_activated);
-    void notifyCollision(int client_fd, char collision_type, int x, int y);
+    int getShardId() const { return shard_id; }
 
-    void startGame();
+    // Queues the packet, the socket is written once at the end of the loop
+    // iteration so everything produced by one tick leaves in one sendmsg()
+    void sendToClient(int client_fd, const SharedPacket &packet) override;
 
-    void endGame(int winner_fd);
+    // Droppable data (game state): over UDP when the client has it,
+    // over TCP otherwise
+    void sendSnapshot(int client_fd, const SharedPacket &packet) override;
 };
 
 #endif
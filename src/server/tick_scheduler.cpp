@@ -0,0 +1,89 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "tick_scheduler.hpp"
+#include "../common/debug.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+TickScheduler::TickScheduler(int tick_rate, uint32_t max_catch_up)
+    : timer_fd(-1), tick_rate(std::max(tick_rate, 1)), max_catch_up(std::max<uint32_t>(max_catch_up, 1)),
+      period(std::chrono::nanoseconds(1000000000LL / this->tick_rate))
+{}
+
+TickScheduler::~TickScheduler()
+{
+    if (timer_fd >= 0)
+        close(timer_fd);
+}
+
+bool TickScheduler::initialize()
+{
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if (timer_fd < 0) {
+        DEBUG_LOG("timerfd_create failed, errno=" + std::to_string(errno));
+        return false;
+    }
+
+    struct itimerspec spec = {};
+    spec.it_interval.tv_sec = period.count() / 1000000000LL;
+    spec.it_interval.tv_nsec = period.count() % 1000000000LL;
+    spec.it_value = spec.it_interval;
+
+    if (timerfd_settime(timer_fd, 0, &spec, nullptr) < 0) {
+        DEBUG_LOG("timerfd_settime failed, errno=" + std::to_string(errno));
+        return false;
+    }
+
+    DEBUG_LOG("Tick scheduler running at " + std::to_string(tick_rate) + " ticks/s");
+    return true;
+}
+
+uint32_t TickScheduler::collectDueTicks()
+{
+    uint64_t expirations = 0;
+
+    if (read(timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return 0;
+
+    if (expirations > 1)
+        stats.late_wakeups++;
+
+    if (expirations > max_catch_up) {
+        stats.ticks_skipped += expirations - max_catch_up;
+        DEBUG_LOG("Tick overrun: skipping " + std::to_string(expirations - max_catch_up) + " ticks");
+        return max_catch_up;
+    }
+    return static_cast<uint32_t>(expirations);
+}
+
+void TickScheduler::recordTick(std::chrono::nanoseconds duration)
+{
+    uint64_t ns = duration.count();
+
+    stats.ticks_run++;
+    stats.total_tick_ns += ns;
+    stats.max_tick_ns = std::max(stats.max_tick_ns, ns);
+
+    if (duration > period)
+        stats.slow_ticks++;
+}
+
+std::string TickScheduler::formatStats() const
+{
+    uint64_t avg_ns = stats.ticks_run ? stats.total_tick_ns / stats.ticks_run : 0;
+
+    return "ticks=" + std::to_string(stats.ticks_run) +
+           " skipped=" + std::to_string(stats.ticks_skipped) +
+           " late_wakeups=" + std::to_string(stats.late_wakeups) +
+           " slow=" + std::to_string(stats.slow_ticks) +
+           " avg_us=" + std::to_string(avg_ns / 1000) +
+           " max_us=" + std::to_string(stats.max_tick_ns / 1000);
+}
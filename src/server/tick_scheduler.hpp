@@ -0,0 +1,63 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef TICK_SCHEDULER_HPP
+    #define TICK_SCHEDULER_HPP
+
+#include <cstdint>
+#include <chrono>
+#include <string>
+
+struct TickStats {
+    uint64_t ticks_run = 0;
+    uint64_t ticks_skipped = 0;     // dropped by the catch-up policy
+    uint64_t late_wakeups = 0;      // woke up with more than one tick due
+    uint64_t slow_ticks = 0;        // one tick took longer than the period
+    uint64_t total_tick_ns = 0;
+    uint64_t max_tick_ns = 0;
+};
+
+// Fixed-rate simulation clock backed by a periodic timerfd. The fd is
+// registered in the reactor like any socket, so ticks and network events
+// share one wait without the simulation rate depending on traffic.
+class TickScheduler {
+private:
+    int timer_fd;
+    int tick_rate;
+    uint32_t max_catch_up;
+    std::chrono::nanoseconds period;
+    TickStats stats;
+
+public:
+    static const int DEFAULT_TICK_RATE = 10;
+    static const uint32_t DEFAULT_MAX_CATCH_UP = 5;
+
+    TickScheduler(int tick_rate, uint32_t max_catch_up = DEFAULT_MAX_CATCH_UP);
+
+    ~TickScheduler();
+
+    TickScheduler(const TickScheduler &) = delete;
+    TickScheduler &operator=(const TickScheduler &) = delete;
+
+    bool initialize();
+
+    int getFd() const { return timer_fd; }
+    int getTickRate() const { return tick_rate; }
+    std::chrono::nanoseconds getPeriod() const { return period; }
+
+    // Acknowledges the timer and returns how many ticks to run now. When
+    // we fell behind by more than max_catch_up ticks the rest is skipped:
+    // running them back to back would only fast-forward the game.
+    uint32_t collectDueTicks();
+
+    void recordTick(std::chrono::nanoseconds duration);
+
+    const TickStats &getStats() const { return stats; }
+    std::string formatStats() const;
+};
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "udp_channel.hpp"
+#include "../common/debug.hpp"
+#include "../common/messages.hpp"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+UdpChannel::UdpChannel() : udp_fd(-1), port(0), token_generator(std::random_device{}())
+{}
+
+UdpChannel::~UdpChannel()
+{
+    if (udp_fd >= 0)
+        close(udp_fd);
+}
+
+bool UdpChannel::initialize()
+{
+    udp_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (udp_fd < 0)
+        return false;
+
+    // Ephemeral port per shard, so a client's datagrams always reach the
+    // shard that holds its TCP connection
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = 0;
+
+    socklen_t addrlen = sizeof(address);
+
+    if (bind(udp_fd, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+        getsockname(udp_fd, (struct sockaddr *)&address, &addrlen) < 0) {
+        close(udp_fd);
+        udp_fd = -1;
+        return false;
+    }
+
+    port = ntohs(address.sin_port);
+    DEBUG_LOG("UDP channel on port " + std::to_string(port));
+    return true;
+}
+
+uint32_t UdpChannel::offer(int client_fd)
+{
+    forget(client_fd);
+
+    uint32_t token;
+
+    do {
+        token = token_generator();
+    } while (token == 0 || peers.count(token));
+
+    peers[token] = Peer{client_fd, false, {}, 0, 0};
+    tokens[client_fd] = token;
+    return token;
+}
+
+void UdpChannel::forget(int client_fd)
+{
+    auto it = tokens.find(client_fd);
+
+    if (it == tokens.end())
+        return;
+
+    peers.erase(it->second);
+    tokens.erase(it);
+}
+
+bool UdpChannel::send(int client_fd, const SharedPacket &packet)
+{
+    auto token_it = tokens.find(client_fd);
+
+    if (token_it == tokens.end() || packet.size() + UdpServerPrefixSchema::SIZE > MAX_DATAGRAM)
+        return false;
+
+    Peer &peer = peers[token_it->second];
+
+    if (!peer.active)
+        return false;
+
+    uint8_t header[UdpServerPrefixSchema::SIZE];
+
+    UdpServerPrefixSchema::encode({ ++peer.send_sequence }, header);
+
+    struct iovec iov[2];
+    iov[0].iov_base = header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = const_cast<uint8_t *>(packet.data());
+    iov[1].iov_len = packet.size();
+
+    struct msghdr msg = {};
+    msg.msg_name = &peer.address;
+    msg.msg_namelen = sizeof(peer.address);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    // A datagram the kernel cannot take right now is simply lost, the
+    // next snapshot supersedes it anyway
+    if (sendmsg(udp_fd, &msg, MSG_NOSIGNAL) < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        DEBUG_LOG("UDP send failed for client " + std::to_string(client_fd) +
+                  ", errno=" + std::to_string(errno));
+    return true;
+}
+
+bool UdpChannel::receive(Datagram &datagram)
+{
+    while (true) {
+        struct sockaddr_in from;
+        socklen_t fromlen = sizeof(from);
+        ssize_t size = recvfrom(udp_fd, recv_buffer, sizeof(recv_buffer), 0,
+                                (struct sockaddr *)&from, &fromlen);
+
+        if (size < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        UdpClientPrefix prefix;
+
+        if (!UdpClientPrefixSchema::decode(recv_buffer, size, prefix))
+            continue;
+
+        auto peer_it = peers.find(prefix.token);
+
+        if (peer_it == peers.end())
+            continue;
+
+        Peer &peer = peer_it->second;
+        uint32_t sequence = prefix.sequence;
+        bool just_activated = !peer.active;
+
+        if (peer.active && (from.sin_addr.s_addr != peer.address.sin_addr.s_addr ||
+                            from.sin_port != peer.address.sin_port))
+            continue;
+
+        // Reordered or duplicated datagram, a newer one was already applied
+        if (peer.active && sequence <= peer.recv_sequence)
+            continue;
+
+        peer.active = true;
+        peer.address = from;
+        peer.recv_sequence = sequence;
+
+        datagram.client_fd = peer.client_fd;
+        datagram.just_activated = just_activated;
+        datagram.messages = recv_buffer + UdpClientPrefixSchema::SIZE;
+        datagram.size = size - UdpClientPrefixSchema::SIZE;
+        return true;
+    }
+}
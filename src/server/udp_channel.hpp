@@ -0,0 +1,78 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef UDP_CHANNEL_HPP
+    #define UDP_CHANNEL_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <unordered_map>
+#include <netinet/in.h>
+#include "../common/packet.hpp"
+
+// Optional unreliable side channel of one shard. A client asks for it with
+// CAP_UDP, gets a token over TCP (MSG_UDP_OFFER) and proves it owns the
+// token with a MSG_UDP_HELLO datagram. From then on game state snapshots go
+// over UDP, everything that must arrive stays on TCP.
+//
+// Server to client datagram: Sequence (4) + framed message
+// Client to server datagram: Token (4) + Sequence (4) + framed messages
+class UdpChannel {
+public:
+    static const size_t MAX_DATAGRAM = 1200; // stays under any sane MTU
+
+    struct Datagram {
+        int client_fd;
+        bool just_activated;        // first datagram from this client
+        const uint8_t *messages;    // framed messages, valid until next receive()
+        size_t size;
+    };
+
+private:
+    struct Peer {
+        int client_fd;
+        bool active;
+        struct sockaddr_in address;
+        uint32_t send_sequence;
+        uint32_t recv_sequence;
+    };
+
+    int udp_fd;
+    uint16_t port;
+    std::unordered_map<uint32_t, Peer> peers;
+    std::unordered_map<int, uint32_t> tokens;
+    std::mt19937 token_generator;
+    uint8_t recv_buffer[MAX_DATAGRAM];
+
+public:
+    UdpChannel();
+
+    ~UdpChannel();
+
+    UdpChannel(const UdpChannel &) = delete;
+    UdpChannel &operator=(const UdpChannel &) = delete;
+
+    bool initialize();
+
+    int getFd() const { return udp_fd; }
+    uint16_t getPort() const { return port; }
+
+    // Returns the token the client has to send back in its datagrams
+    uint32_t offer(int client_fd);
+
+    void forget(int client_fd);
+
+    // false when the client has no active UDP path or the packet does not
+    // fit in a datagram, the caller then sends it over TCP
+    bool send(int client_fd, const SharedPacket &packet);
+
+    // Reads datagrams until one is valid, false once the socket is drained
+    bool receive(Datagram &datagram);
+};
+
+#endif
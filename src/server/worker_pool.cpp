@@ -0,0 +1,112 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "worker_pool.hpp"
+#include "../common/debug.hpp"
+#include <iostream>
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
+WorkerPool::WorkerPool(const ServerConfig &config)
+    : config(config), matchmaker(std::max(config.worker_threads, 1))
+{
+    g_logger.setDebugMode(config.debug_mode);
+}
+
+WorkerPool::~WorkerPool()
+{
+    for (auto &thread : threads) {
+        if (thread.joinable())
+            thread.join();
+    }
+}
+
+bool WorkerPool::initialize()
+{
+    if (!loadGameMap() || !matchmaker.initialize())
+        return false;
+
+    for (int i = 0; i < config.worker_threads; i++) {
+        auto shard = std::make_unique<Server>(config, game_map, map_cache, matchmaker, i);
+
+        if (!shard->initialize()) {
+            std::cerr << "Shard " << i << " failed to start." << std::endl;
+            return false;
+        }
+        shards.push_back(std::move(shard));
+    }
+
+    std::cout << "Port is: " << config.port << std::endl;
+    DEBUG_LOG("Debug mode is " + std::string(config.debug_mode ? "Here" : "Not here"));
+    DEBUG_LOG("Running " + std::to_string(shards.size()) + " worker(s)");
+    return true;
+}
+
+bool WorkerPool::loadGameMap()
+{
+    if (!game_map.loadFromFile(config.map_path)) {
+        std::cerr << "T as chie la map mon reuf: " << config.map_path;
+        if (!game_map.getLastError().empty())
+            std::cerr << " (" << game_map.getLastError() << ")";
+        std::cerr << std::endl;
+        return false;
+    }
+
+    DEBUG_LOG("Map loaded successfully: " + std::to_string(game_map.getWidth()) +
+              "x" + std::to_string(game_map.getHeight()));
+    return map_cache.build(game_map);
+}
+
+void WorkerPool::run()
+{
+    // Shard 0 runs on the calling thread, so a single worker is exactly
+    // the old single-threaded server
+    for (size_t i = 1; i < shards.size(); i++) {
+        threads.emplace_back(&WorkerPool::runShard, this, i);
+    }
+
+    runShard(0);
+
+    for (auto &thread : threads) {
+        if (thread.joinable())
+            thread.join();
+    }
+}
+
+void WorkerPool::runShard(size_t index)
+{
+    // Shard 0 is the main thread, renaming it would rename the process
+    if (index > 0) {
+        std::string name = "jetpack-w" + std::to_string(index);
+
+        pthread_setname_np(pthread_self(), name.c_str());
+    }
+
+    if (config.pin_threads)
+        pinToCpu(index);
+
+    shards[index]->run();
+}
+
+void WorkerPool::pinToCpu(size_t index)
+{
+    unsigned int cpu_count = std::thread::hardware_concurrency();
+
+    if (cpu_count == 0)
+        return;
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(index % cpu_count, &cpus);
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+        DEBUG_LOG("Could not pin worker " + std::to_string(index) + " to a cpu");
+    else
+        DEBUG_LOG("Worker " + std::to_string(index) + " pinned to cpu " +
+                  std::to_string(index % cpu_count));
+}
@@ -0,0 +1,48 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#ifndef WORKER_POOL_HPP
+    #define WORKER_POOL_HPP
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include "server.hpp"
+#include "map_cache.hpp"
+#include "matchmaker.hpp"
+
+// Loads the map once and runs config.worker_threads independent Server
+// shards. Each shard owns its listener, reactor and rooms, the only shared
+// state is the immutable map and its encoded packets, and the matchmaker
+// that keeps the players of a match on the same shard.
+class WorkerPool {
+private:
+    ServerConfig config;
+    Map game_map;
+    MapCache map_cache;
+    Matchmaker matchmaker;
+
+    std::vector<std::unique_ptr<Server>> shards;
+    std::vector<std::thread> threads;
+
+    bool loadGameMap();
+
+    void runShard(size_t index);
+
+    void pinToCpu(size_t index);
+
+public:
+    WorkerPool(const ServerConfig &config);
+
+    ~WorkerPool();
+
+    bool initialize();
+
+    void run();
+};
+
+#endif
@@ -0,0 +1,369 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "../common/protocol.hpp"
+#include "../common/snapshot.hpp"
+#include "../common/packet_io.hpp"
+#include "../common/map.hpp"
+#include "../common/debug.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+// Micro-benchmarks of the protocol and map code, printed as JSON so two
+// releases can be compared. Each case runs until it has taken at least
+// the minimum time, results are per operation.
+//
+// {
+//   "compiler": "...", "optimized": false, "min_time_ms": 200,
+//   "results": [
+//     { "name": "...", "params": { ... }, "iterations": 123,
+//       "ns_per_op": 1.5, "bytes_per_op": 64 }
+//   ]
+// }
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    int min_time_ms = 200;
+    bool quick = false;
+    std::string output;
+    std::string temp_dir = "/tmp";
+    bool debug_mode = false;
+};
+
+struct BenchResult {
+    std::string name;
+    std::string params;
+    uint64_t iterations;
+    double ns_per_op;
+    size_t bytes_per_op;
+};
+
+// Written by every case so the compiler cannot drop the work
+static volatile size_t sink = 0;
+
+static BenchResult measure(const std::string &name, const std::string &params, size_t bytes_per_op,
+                           int min_time_ms, const std::function<void()> &operation)
+{
+    uint64_t iterations = 0;
+    uint64_t batch = 1;
+    Clock::time_point start = Clock::now();
+    Clock::duration elapsed;
+
+    // Batches double until the clock is read rarely enough not to matter
+    do {
+        for (uint64_t i = 0; i < batch; i++)
+            operation();
+        iterations += batch;
+        batch = std::min<uint64_t>(batch * 2, 1 << 20);
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(min_time_ms));
+
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+
+    return BenchResult{ name, params, iterations, ns / iterations, bytes_per_op };
+}
+
+//=============================================================================
+// Inputs
+//=============================================================================
+
+// Same map for the same size: a floor of coins, hazards here and there
+static std::string makeMapText(size_t width, size_t height)
+{
+    std::string text;
+    uint32_t state = 0x9E3779B9u ^ static_cast<uint32_t>(width * 31 + height);
+
+    text.reserve((width + 1) * height);
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            state = state * 1664525u + 1013904223u;
+            uint32_t roll = state >> 24;
+            text += roll < 40 ? 'c' : roll < 48 ? 'e' : '_';
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+static Snapshot makeSnapshot(size_t players)
+{
+    Snapshot snapshot;
+
+    snapshot.sequence = 1;
+    for (size_t i = 0; i < players; i++)
+        snapshot.players.push_back(PlayerSnapshot{
+            static_cast<uint8_t>(i), 1234, static_cast<uint16_t>(i % 20), static_cast<uint16_t>(i * 3), i % 2 == 0
+        });
+    return snapshot;
+}
+
+static std::string param(const std::string &key, size_t value)
+{
+    return "\"" + key + "\": " + std::to_string(value);
+}
+
+//=============================================================================
+// Cases
+//=============================================================================
+
+static void benchProtocol(const BenchConfig &config, std::vector<BenchResult> &results)
+{
+    for (size_t size : { 0, 8, 64, 1024, 65536 }) {
+        std::vector<uint8_t> payload(size, 0x42);
+
+        results.push_back(measure("Protocol::createPacket", param("payload_bytes", size),
+                                  size + sizeof(MessageHeader), config.min_time_ms, [&]() {
+            sink = sink + Protocol::createPacket(MSG_GAME_STATE, payload).size();
+        }));
+    }
+
+    // The same packets written in place, without the intermediate payload
+    for (size_t size : { 0, 8, 64, 1024, 65536 }) {
+        std::vector<uint8_t> payload(size, 0x42);
+        std::vector<uint8_t> buffer(sizeof(MessageHeader) + size);
+
+        results.push_back(measure("PacketWriter", param("payload_bytes", size),
+                                  size + sizeof(MessageHeader), config.min_time_ms, [&]() {
+            PacketWriter writer(buffer, MSG_GAME_STATE);
+
+            writer.bytes(payload.data(), payload.size());
+            sink = sink + writer.finish();
+        }));
+    }
+
+    std::vector<uint8_t> packet = Protocol::createPacket(MSG_GAME_STATE, std::vector<uint8_t>(64, 0));
+    MessageHeader header;
+
+    results.push_back(measure("Protocol::parseHeader", "", sizeof(MessageHeader), config.min_time_ms, [&]() {
+        Protocol::parseHeader(reinterpret_cast<const char *>(packet.data()), packet.size(), header);
+        sink = sink + Protocol::getPayloadSize(header);
+    }));
+}
+
+static void benchGameState(const BenchConfig &config, std::vector<BenchResult> &results)
+{
+    for (size_t players : { 2, 8, 64, 255 }) {
+        Snapshot snapshot = makeSnapshot(players);
+        std::vector<uint8_t> packet(sizeof(MessageHeader) + players * StateRecords::RECORD_SIZE);
+        std::vector<PlayerSnapshot> records;
+        PacketWriter packet_writer(packet, MSG_GAME_STATE);
+
+        for (const PlayerSnapshot &player : snapshot.players)
+            StateRecords::encode(player, packet_writer);
+        packet_writer.finish();
+
+        std::vector<uint8_t> data(packet.begin() + sizeof(MessageHeader), packet.end());
+
+        // What the client does with every MSG_GAME_STATE
+        results.push_back(measure("StateRecords::decode", param("players", players), data.size(),
+                                  config.min_time_ms, [&]() {
+            StateRecords::decode(data.data(), data.size(), records);
+            sink = sink + records.size();
+        }));
+
+        results.push_back(measure("StateRecords::encode", param("players", players), data.size(),
+                                  config.min_time_ms, [&]() {
+            PacketWriter writer(packet, MSG_GAME_STATE);
+
+            for (const PlayerSnapshot &player : snapshot.players)
+                StateRecords::encode(player, writer);
+            sink = sink + writer.finish();
+        }));
+
+        // One tick later: everybody ran forward, every third player moved up
+        Snapshot next = snapshot;
+        std::vector<uint8_t> delta;
+
+        next.sequence++;
+        for (size_t i = 0; i < next.players.size(); i++) {
+            next.players[i].x += 3;
+            if (i % 3 == 0)
+                next.players[i].y++;
+        }
+        SnapshotCodec::encode(&snapshot, next, delta);
+
+        results.push_back(measure("SnapshotCodec::encode", param("players", players), delta.size(),
+                                  config.min_time_ms, [&]() {
+            delta.clear();
+            SnapshotCodec::encode(&snapshot, next, delta);
+            sink = sink + delta.size();
+        }));
+
+        Snapshot decoded;
+
+        results.push_back(measure("SnapshotCodec::decode", param("players", players), delta.size(),
+                                  config.min_time_ms, [&]() {
+            SnapshotCodec::decode(&snapshot, delta.data(), delta.size(), decoded);
+            sink = sink + decoded.players.size();
+        }));
+    }
+}
+
+static bool benchMaps(const BenchConfig &config, std::vector<BenchResult> &results)
+{
+    std::vector<std::pair<size_t, size_t>> sizes = { {100, 10}, {1000, 20}, {10000, 20}, {100000, 30} };
+
+    if (config.quick)
+        sizes.resize(2);
+
+    for (auto [width, height] : sizes) {
+        std::string text = makeMapText(width, height);
+        std::string text_path = config.temp_dir + "/jetpack_bench_" + std::to_string(getpid()) + ".txt";
+        std::string smap_path = config.temp_dir + "/jetpack_bench_" + std::to_string(getpid()) + ".smap";
+        std::string params = param("width", width) + ", " + param("height", height);
+        Map map;
+
+        std::ofstream(text_path, std::ios::binary) << text;
+        if (!map.loadFromFile(text_path) || !map.saveAsSmap(smap_path)) {
+            std::cerr << "Cannot prepare the " << width << "x" << height << " map in " << config.temp_dir << std::endl;
+            std::remove(text_path.c_str());
+            std::remove(smap_path.c_str());
+            return false;
+        }
+
+        std::vector<uint8_t> data = map.serialize();
+
+        results.push_back(measure("Map::serialize", params, data.size(), config.min_time_ms, [&]() {
+            sink = sink + map.serialize().size();
+        }));
+
+        results.push_back(measure("Map::loadFromData", params, data.size(), config.min_time_ms, [&]() {
+            Map loaded;
+
+            loaded.loadFromData(data);
+            sink = sink + loaded.getCoinCount();
+        }));
+
+        results.push_back(measure("Map::loadFromFile", params + ", \"format\": \"text\"", text.size(),
+                                  config.min_time_ms, [&]() {
+            Map loaded;
+
+            loaded.loadFromFile(text_path);
+            sink = sink + loaded.getCoinCount();
+        }));
+
+        results.push_back(measure("Map::loadFromFile", params + ", \"format\": \"smap\"", text.size(),
+                                  config.min_time_ms, [&]() {
+            Map loaded;
+
+            loaded.loadFromFile(smap_path);
+            sink = sink + loaded.getCoinCount();
+        }));
+
+        std::remove(text_path.c_str());
+        std::remove(smap_path.c_str());
+    }
+    return true;
+}
+
+//=============================================================================
+// Output
+//=============================================================================
+
+static std::string toJson(const BenchConfig &config, const std::vector<BenchResult> &results)
+{
+    std::ostringstream json;
+
+    json << "{\n";
+    json << "  \"compiler\": \"" << __VERSION__ << "\",\n";
+#ifdef __OPTIMIZE__
+    json << "  \"optimized\": true,\n";
+#else
+    json << "  \"optimized\": false,\n";
+#endif
+    json << "  \"min_time_ms\": " << config.min_time_ms << ",\n";
+    json << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &result = results[i];
+
+        json << "    { \"name\": \"" << result.name << "\", \"params\": { " << result.params << " }, "
+             << "\"iterations\": " << result.iterations << ", \"ns_per_op\": " << result.ns_per_op << ", "
+             << "\"bytes_per_op\": " << result.bytes_per_op << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n";
+    json << "}\n";
+    return json.str();
+}
+
+//=============================================================================
+// Main
+//=============================================================================
+
+void printUsage(const char *programme)
+{
+    std::cerr << "Usage: " << programme << " [-o <file.json>] [-m <ms>] [-q] [-T <dir>] [-d]" << std::endl;
+    std::cerr << "  -o <file>    Write the JSON results there instead of stdout" << std::endl;
+    std::cerr << "  -m <ms>      Minimum time per case (default 200)" << std::endl;
+    std::cerr << "  -q           Quick run, small maps only" << std::endl;
+    std::cerr << "  -T <dir>     Directory for the temporary map files (default /tmp)" << std::endl;
+    std::cerr << "  -d           Enable debug mode" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    BenchConfig config;
+    std::vector<BenchResult> results;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:m:qT:d")) != -1) {
+        switch (opt) {
+            case 'o':
+                config.output = optarg;
+                break;
+            case 'm':
+                config.min_time_ms = std::atoi(optarg);
+                break;
+            case 'q':
+                config.quick = true;
+                break;
+            case 'T':
+                config.temp_dir = optarg;
+                break;
+            case 'd':
+                config.debug_mode = true;
+                break;
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (config.min_time_ms <= 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    g_logger.setDebugMode(config.debug_mode);
+
+    benchProtocol(config, results);
+    benchGameState(config, results);
+    if (!benchMaps(config, results))
+        return 1;
+
+    std::string json = toJson(config, results);
+
+    if (config.output.empty()) {
+        std::cout << json;
+        return 0;
+    }
+
+    std::ofstream file(config.output);
+
+    file << json;
+    if (!file) {
+        std::cerr << "Cannot write " << config.output << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "../client/client.hpp"
+#include "../client/state.hpp"
+#include "../common/debug.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <unistd.h>
+
+// Plays one match with the real Client network code, without a window:
+// every client goes through connectToServer() and the network thread the
+// same way jetpack_client does. Exits 0 when every client got the whole
+// map and game states showing its player, 1 otherwise.
+//
+// The client announces CAP_DELTA_STATE, so its game states must all be
+// MSG_GAME_STATE_DELTA, acked, and some of them encoded against a
+// snapshot it acked: that one proves the server got the acks.
+//
+// With -u the server was started with -u too, and every client must
+// switch to the UDP channel and get game states by datagram.
+
+using Clock = std::chrono::steady_clock;
+
+struct CheckConfig {
+    std::string host = "127.0.0.1";
+    int port = -1;
+    size_t clients = 2;
+    int timeout_s = 10;
+    bool udp = false;
+    bool debug_mode = false;
+};
+
+// One client and the state its network thread fills
+struct CheckedClient {
+    std::unique_ptr<GameState> state;
+    std::unique_ptr<Client> client;
+};
+
+void printUsage(const char *programme)
+{
+    std::cerr << "Usage: " << programme << " -p <port> [-h <host>] [-n <clients>] [-s <seconds>] [-u] [-d]" << std::endl;
+    std::cerr << "  -p <port>    Server port" << std::endl;
+    std::cerr << "  -h <host>    Server address (default 127.0.0.1)" << std::endl;
+    std::cerr << "  -n <clients> Clients, the players of one match (default 2)" << std::endl;
+    std::cerr << "  -s <seconds> Give up after (default 10)" << std::endl;
+    std::cerr << "  -u           The server runs with -u, game states must come over UDP" << std::endl;
+    std::cerr << "  -d           Enable debug mode" << std::endl;
+}
+
+static bool parseArguments(int argc, char **argv, CheckConfig &config)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:h:n:s:ud")) != -1) {
+        switch (opt) {
+            case 'p':
+                config.port = std::atoi(optarg);
+                break;
+            case 'h':
+                config.host = optarg;
+                break;
+            case 'n':
+                config.clients = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 's':
+                config.timeout_s = std::atoi(optarg);
+                break;
+            case 'u':
+                config.udp = true;
+                break;
+            case 'd':
+                config.debug_mode = true;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    return config.port > 0 && config.clients > 0 && config.timeout_s > 0;
+}
+
+static bool hasWholeMap(const Client &client)
+{
+    return client.getMap().getWidth() > 0 && client.getLoadedColumns() == client.getMap().getWidth();
+}
+
+static bool seesItself(CheckedClient &checked)
+{
+    int player_number = checked.client->getPlayerNumber();
+
+    return player_number >= 0 && checked.state->getPlayers().count(player_number) > 0;
+}
+
+static bool usesDeltas(const Client &client)
+{
+    const Client::Stats &stats = client.getStats();
+
+    return stats.full_states == 0 && stats.delta_states > 0 && stats.state_acks > 0 &&
+           stats.baselined_states > 0;
+}
+
+static bool usesUdp(const Client &client)
+{
+    return client.isUdpReady() && client.getStats().udp_states > 0;
+}
+
+static bool isDone(const CheckConfig &config, CheckedClient &checked)
+{
+    return hasWholeMap(*checked.client) && seesItself(checked) && usesDeltas(*checked.client) &&
+           (!config.udp || usesUdp(*checked.client));
+}
+
+// Prints what is missing, true when nothing is
+static bool report(const CheckConfig &config, size_t index, CheckedClient &checked)
+{
+    Client &client = *checked.client;
+    bool passed = true;
+
+    if (!client.isConnected()) {
+        std::cerr << "client " << index << ": not connected" << std::endl;
+        return false;
+    }
+    if (!hasWholeMap(client)) {
+        std::cerr << "client " << index << ": map incomplete, " << client.getLoadedColumns() << "/"
+                  << client.getMap().getWidth() << " columns" << std::endl;
+        passed = false;
+    }
+    if (!seesItself(checked)) {
+        std::cerr << "client " << index << ": no game state for player " << client.getPlayerNumber() << std::endl;
+        passed = false;
+    }
+    if (!usesDeltas(client)) {
+        const Client::Stats &stats = client.getStats();
+
+        std::cerr << "client " << index << ": " << stats.full_states << " full states, "
+                  << stats.delta_states << " deltas, " << stats.baselined_states << " against an acked baseline, "
+                  << stats.state_acks << " acks" << std::endl;
+        passed = false;
+    }
+    if (config.udp && !usesUdp(client)) {
+        std::cerr << "client " << index << ": UDP " << (client.isUdpReady() ? "ready" : "never ready") << ", "
+                  << client.getStats().udp_states << " states by datagram" << std::endl;
+        passed = false;
+    }
+    if (passed)
+        std::cout << "client " << index << ": player " << client.getPlayerNumber() << ", map "
+                  << client.getMap().getWidth() << "x" << client.getMap().getHeight() << ", "
+                  << client.getStats().delta_states << " deltas acked, "
+                  << client.getStats().udp_states << " by datagram" << std::endl;
+    return passed;
+}
+
+int main(int argc, char **argv)
+{
+    CheckConfig config;
+    std::vector<CheckedClient> clients;
+
+    if (!parseArguments(argc, argv, config)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    for (size_t i = 0; i < config.clients; i++) {
+        CheckedClient checked;
+
+        checked.state = std::make_unique<GameState>();
+        checked.client = std::make_unique<Client>(config.host, config.port, config.debug_mode);
+        checked.client->setGameState(checked.state.get());
+        if (!checked.client->initialize()) {
+            std::cerr << "client " << i << ": cannot connect" << std::endl;
+            return 1;
+        }
+        checked.client->startNetwork();
+        clients.push_back(std::move(checked));
+    }
+
+    Clock::time_point end = Clock::now() + std::chrono::seconds(config.timeout_s);
+    bool done = false;
+
+    while (!done && Clock::now() < end) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        done = true;
+        for (CheckedClient &checked : clients)
+            done = done && isDone(config, checked);
+    }
+
+    bool passed = true;
+
+    for (size_t i = 0; i < clients.size(); i++) {
+        passed = report(config, i, clients[i]) && passed;
+        clients[i].client->stop();
+    }
+
+    std::cout << (passed ? "PASS" : "FAIL") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,493 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "../common/protocol.hpp"
+#include "../common/messages.hpp"
+#include "../common/frame_reader.hpp"
+#include "../common/snapshot.hpp"
+#include "../common/debug.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Headless bots for capacity tests: N connections from one process, each
+// doing the MSG_CONNECT handshake, playing with a jetpack toggled on a
+// schedule and acking delta snapshots like the real client. Measures:
+//   connect latency  connect() to the first map message
+//   snapshot jitter  gap between two game states minus the tick period
+//   input round trip MSG_PLAYER_INPUT to the first game state showing it
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadgenConfig {
+    std::string host = "127.0.0.1";
+    int port = -1;
+    size_t bots = 100;
+    int duration_s = 10;
+    int input_interval_ms = 300;
+    int tick_rate = 10;
+    uint8_t capabilities = CAP_DELTA_STATE | CAP_MAP_CHUNKS;
+    bool reconnect = false;
+    bool debug_mode = false;
+};
+
+struct Bot {
+    enum State {
+        CONNECTING,
+        WAITING_MAP,
+        WAITING_GAME,
+        PLAYING,
+        DONE
+    };
+
+    static const size_t BUFFER_SIZE = 4096;
+
+    int fd = -1;
+    State state = DONE;
+    FrameReader reader{BUFFER_SIZE, Protocol::MAX_PAYLOAD_SIZE};
+    Clock::time_point connect_start;
+
+    int player_number = -1;
+    bool jet = false;
+    Clock::time_point next_input;
+    bool input_pending = false;
+    Clock::time_point input_sent;
+
+    bool has_snapshot = false;
+    Clock::time_point last_snapshot;
+    SnapshotHistory history;
+    Snapshot decoded;
+    std::vector<PlayerSnapshot> records;
+    uint32_t last_sequence = 0;
+};
+
+struct Samples {
+    std::vector<double> connect_ms;
+    std::vector<double> interval_ms;
+    std::vector<double> jitter_ms;
+    std::vector<double> round_trip_ms;
+    size_t connect_failures = 0;
+    size_t disconnects = 0;
+    size_t games = 0;
+    size_t snapshots = 0;
+    size_t inputs = 0;
+    size_t lost_inputs = 0;
+};
+
+// An input nobody saw after that long is counted as lost
+static const int INPUT_TIMEOUT_MS = 1000;
+
+static double millisecondsSince(Clock::time_point start, Clock::time_point now)
+{
+    return std::chrono::duration<double, std::milli>(now - start).count();
+}
+
+static void sendPacket(Bot &bot, const uint8_t *packet, size_t size)
+{
+    // A few bytes at a time, the socket buffer does not fill up
+    if (send(bot.fd, packet, size, MSG_NOSIGNAL) < 0)
+        DEBUG_LOG("Bot " + std::to_string(bot.fd) + ": send failed: " + strerror(errno));
+}
+
+//=============================================================================
+// Connections
+//=============================================================================
+
+static bool startConnect(Bot &bot, int epoll_fd, const sockaddr_in &address)
+{
+    bot.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (bot.fd < 0)
+        return false;
+
+    int one = 1;
+    setsockopt(bot.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    bot.connect_start = Clock::now();
+    if (connect(bot.fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 &&
+        errno != EINPROGRESS) {
+        close(bot.fd);
+        bot.fd = -1;
+        return false;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.ptr = &bot;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, bot.fd, &event);
+
+    bot.state = Bot::CONNECTING;
+    bot.player_number = -1;
+    bot.jet = false;
+    bot.input_pending = false;
+    bot.has_snapshot = false;
+    bot.last_sequence = 0;
+    bot.history = SnapshotHistory();
+    bot.reader = FrameReader(Bot::BUFFER_SIZE, Protocol::MAX_PAYLOAD_SIZE);
+    return true;
+}
+
+static void closeBot(Bot &bot, int epoll_fd)
+{
+    if (bot.fd >= 0) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, bot.fd, nullptr);
+        close(bot.fd);
+    }
+    bot.fd = -1;
+    bot.state = Bot::DONE;
+}
+
+static void finishConnect(Bot &bot, int epoll_fd, const LoadgenConfig &config, Samples &samples)
+{
+    int error = 0;
+    socklen_t length = sizeof(error);
+
+    getsockopt(bot.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+    if (error != 0) {
+        samples.connect_failures++;
+        closeBot(bot, epoll_fd);
+        return;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = &bot;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, bot.fd, &event);
+
+    auto packet = ConnectSchema::packet({ config.capabilities });
+
+    bot.state = Bot::WAITING_MAP;
+    sendPacket(bot, packet.data(), packet.size());
+}
+
+//=============================================================================
+// Messages
+//=============================================================================
+
+static void handleGameState(Bot &bot, const FrameReader::Frame &frame, const LoadgenConfig &config,
+                            Samples &samples, Clock::time_point now)
+{
+    const std::vector<PlayerSnapshot> *players = &bot.records;
+
+    if (frame.header.type == MSG_GAME_STATE) {
+        StateRecords::decode(frame.payload, frame.size, bot.records);
+    } else {
+        uint32_t sequence = 0;
+        uint32_t baseline = 0;
+
+        if (!SnapshotCodec::readSequences(frame.payload, frame.size, sequence, baseline) ||
+            sequence <= bot.last_sequence ||
+            !SnapshotCodec::decode(bot.history.find(baseline), frame.payload, frame.size, bot.decoded))
+            return;
+
+        bot.history.store(bot.decoded);
+        bot.last_sequence = sequence;
+        players = &bot.decoded.players;
+
+        auto ack = StateAckSchema::packet({ sequence });
+
+        sendPacket(bot, ack.data(), ack.size());
+    }
+
+    samples.snapshots++;
+    if (bot.has_snapshot) {
+        double interval = millisecondsSince(bot.last_snapshot, now);
+
+        samples.interval_ms.push_back(interval);
+        samples.jitter_ms.push_back(std::abs(interval - 1000.0 / config.tick_rate));
+    }
+    bot.has_snapshot = true;
+    bot.last_snapshot = now;
+
+    if (!bot.input_pending)
+        return;
+
+    for (const PlayerSnapshot &player : *players) {
+        if (player.player_number == bot.player_number && player.jet_active == bot.jet) {
+            samples.round_trip_ms.push_back(millisecondsSince(bot.input_sent, now));
+            bot.input_pending = false;
+        }
+    }
+}
+
+static void handleFrame(Bot &bot, const FrameReader::Frame &frame, const LoadgenConfig &config,
+                        Samples &samples, Clock::time_point now)
+{
+    switch (frame.header.type) {
+        case MSG_MAP_DATA:
+        case MSG_MAP_INFO:
+            if (bot.state == Bot::WAITING_MAP) {
+                samples.connect_ms.push_back(millisecondsSince(bot.connect_start, now));
+                bot.state = Bot::WAITING_GAME;
+            }
+            break;
+
+        case MSG_GAME_START:
+            bot.player_number = frame.size >= 1 ? frame.payload[0] : -1;
+            bot.state = Bot::PLAYING;
+            // Spread the inputs of the bots over the interval
+            bot.next_input = now + std::chrono::milliseconds(std::rand() % config.input_interval_ms);
+            samples.games++;
+            break;
+
+        case MSG_GAME_STATE:
+        case MSG_GAME_STATE_DELTA:
+            handleGameState(bot, frame, config, samples, now);
+            break;
+
+        case MSG_GAME_END:
+            bot.state = Bot::DONE;
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void readBot(Bot &bot, int epoll_fd, const LoadgenConfig &config, Samples &samples)
+{
+    Clock::time_point now = Clock::now();
+
+    while (true) {
+        ssize_t bytes_read = bot.reader.readFrom(bot.fd);
+        int read_errno = errno;
+        FrameReader::Frame frame;
+        FrameReader::Result result;
+
+        while ((result = bot.reader.next(frame)) == FrameReader::FRAME_READY)
+            handleFrame(bot, frame, config, samples, now);
+
+        if (result == FrameReader::FRAME_TOO_LARGE || bytes_read == 0 ||
+            (bytes_read < 0 && read_errno != EAGAIN && read_errno != EWOULDBLOCK && read_errno != ENOBUFS)) {
+            if (bot.state != Bot::DONE)
+                samples.disconnects++;
+            closeBot(bot, epoll_fd);
+            return;
+        }
+        if (bytes_read < 0 && read_errno != ENOBUFS)
+            return;
+    }
+}
+
+static void sendInputs(std::vector<std::unique_ptr<Bot>> &bots, const LoadgenConfig &config,
+                       Samples &samples, Clock::time_point now)
+{
+    for (auto &bot : bots) {
+        if (bot->state != Bot::PLAYING)
+            continue;
+
+        if (bot->input_pending && millisecondsSince(bot->input_sent, now) > INPUT_TIMEOUT_MS) {
+            samples.lost_inputs++;
+            bot->input_pending = false;
+        }
+
+        if (bot->input_pending || now < bot->next_input)
+            continue;
+
+        bot->jet = !bot->jet;
+        bot->input_pending = true;
+        bot->input_sent = now;
+        bot->next_input = now + std::chrono::milliseconds(config.input_interval_ms);
+
+        auto packet = PlayerInputSchema::packet({ bot->jet });
+
+        sendPacket(*bot, packet.data(), packet.size());
+        samples.inputs++;
+    }
+}
+
+//=============================================================================
+// Report
+//=============================================================================
+
+static void printPercentiles(const std::string &name, std::vector<double> &values)
+{
+    std::cout << name;
+    if (values.empty()) {
+        std::cout << "no samples" << std::endl;
+        return;
+    }
+
+    std::sort(values.begin(), values.end());
+    for (double percentile : { 50.0, 90.0, 99.0, 99.9 }) {
+        size_t index = std::min(values.size() - 1, static_cast<size_t>(percentile / 100 * values.size()));
+
+        std::cout << "p" << percentile << " " << values[index] << "  ";
+    }
+    std::cout << "max " << values.back() << " ms (" << values.size() << " samples)" << std::endl;
+}
+
+static void printReport(const LoadgenConfig &config, Samples &samples)
+{
+    std::cout << "bots:               " << config.bots << std::endl;
+    std::cout << "games started:      " << samples.games << std::endl;
+    std::cout << "connect failures:   " << samples.connect_failures << std::endl;
+    std::cout << "disconnects:        " << samples.disconnects << std::endl;
+    std::cout << "snapshots:          " << samples.snapshots << std::endl;
+    std::cout << "inputs:             " << samples.inputs << " (" << samples.lost_inputs << " never seen)" << std::endl;
+    printPercentiles("connect latency:    ", samples.connect_ms);
+    printPercentiles("snapshot interval:  ", samples.interval_ms);
+    printPercentiles("snapshot jitter:    ", samples.jitter_ms);
+    printPercentiles("input round trip:   ", samples.round_trip_ms);
+}
+
+//=============================================================================
+// Main
+//=============================================================================
+
+void printUsage(const char *programme)
+{
+    std::cerr << "Usage: " << programme << " -p <port> [-h <host>] [-n <bots>] [-s <seconds>] [-i <ms>] [-t <rate>] [-c <caps>] [-k] [-d]" << std::endl;
+    std::cerr << "  -p <port>    Server port" << std::endl;
+    std::cerr << "  -h <host>    Server address (default 127.0.0.1)" << std::endl;
+    std::cerr << "  -n <bots>    Connections (default 100)" << std::endl;
+    std::cerr << "  -s <seconds> Test duration (default 10)" << std::endl;
+    std::cerr << "  -i <ms>      Jetpack toggled every <ms> (default 300)" << std::endl;
+    std::cerr << "  -t <rate>    Server tick rate, for the jitter (default 10)" << std::endl;
+    std::cerr << "  -c <caps>    MSG_CONNECT capabilities (default 5, delta state and map chunks)" << std::endl;
+    std::cerr << "  -k           Reconnect bots whose game is over" << std::endl;
+    std::cerr << "  -d           Enable debug mode" << std::endl;
+}
+
+static bool parseArguments(int argc, char **argv, LoadgenConfig &config)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:h:n:s:i:t:c:kd")) != -1) {
+        switch (opt) {
+            case 'p':
+                config.port = std::atoi(optarg);
+                break;
+            case 'h':
+                config.host = optarg;
+                break;
+            case 'n':
+                config.bots = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 's':
+                config.duration_s = std::atoi(optarg);
+                break;
+            case 'i':
+                config.input_interval_ms = std::atoi(optarg);
+                break;
+            case 't':
+                config.tick_rate = std::atoi(optarg);
+                break;
+            case 'c':
+                config.capabilities = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'k':
+                config.reconnect = true;
+                break;
+            case 'd':
+                config.debug_mode = true;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    return config.port > 0 && config.bots > 0 && config.duration_s > 0 &&
+           config.input_interval_ms > 0 && config.tick_rate > 0;
+}
+
+// Every bot is a socket, the default 1024 files do not go far
+static void raiseFileLimit(size_t bots)
+{
+    rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < bots + 16) {
+        limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, bots + 16);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    LoadgenConfig config;
+    Samples samples;
+    sockaddr_in address = {};
+
+    if (!parseArguments(argc, argv, config)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    g_logger.setDebugMode(config.debug_mode);
+    raiseFileLimit(config.bots);
+
+    address.sin_family = AF_INET;
+    address.sin_port = htons(config.port);
+    if (inet_pton(AF_INET, config.host.c_str(), &address.sin_addr) != 1) {
+        std::cerr << "Invalid address: " << config.host << std::endl;
+        return 1;
+    }
+
+    int epoll_fd = epoll_create1(0);
+    std::vector<std::unique_ptr<Bot>> bots;
+    std::vector<epoll_event> events(256);
+
+    if (epoll_fd < 0) {
+        perror("epoll_create1");
+        return 1;
+    }
+
+    for (size_t i = 0; i < config.bots; i++) {
+        bots.push_back(std::make_unique<Bot>());
+        if (!startConnect(*bots.back(), epoll_fd, address))
+            samples.connect_failures++;
+    }
+
+    Clock::time_point end = Clock::now() + std::chrono::seconds(config.duration_s);
+
+    while (Clock::now() < end) {
+        int ready = epoll_wait(epoll_fd, events.data(), events.size(), 1);
+
+        for (int i = 0; i < ready; i++) {
+            Bot &bot = *static_cast<Bot *>(events[i].data.ptr);
+
+            if (bot.fd < 0)
+                continue;
+            if (bot.state == Bot::CONNECTING)
+                finishConnect(bot, epoll_fd, config, samples);
+            else
+                readBot(bot, epoll_fd, config, samples);
+        }
+
+        Clock::time_point now = Clock::now();
+
+        sendInputs(bots, config, samples, now);
+
+        if (!config.reconnect)
+            continue;
+        for (auto &bot : bots) {
+            if (bot->state != Bot::DONE)
+                continue;
+            closeBot(*bot, epoll_fd);
+            if (!startConnect(*bot, epoll_fd, address))
+                samples.connect_failures++;
+        }
+    }
+
+    for (auto &bot : bots)
+        closeBot(*bot, epoll_fd);
+    close(epoll_fd);
+
+    printReport(config, samples);
+    return 0;
+}
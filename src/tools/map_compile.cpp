@@ -0,0 +1,150 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "../common/map.hpp"
+#include "../common/debug.hpp"
+#include <iostream>
+#include <unistd.h>
+
+void printUsage(const char *programme)
+{
+    std::cerr << "Usage: " << programme << " [-d] [-p] [-o <out.smap>] <map>" << std::endl;
+    std::cerr << "       " << programme << " [-d] -v <map.smap>" << std::endl;
+    std::cerr << "  Compiles a text map to .smap (default: <map> with a .smap extension)" << std::endl;
+    std::cerr << "  -o <file>   Output file" << std::endl;
+    std::cerr << "  -v          Only verify an existing .smap (checksum and index)" << std::endl;
+    std::cerr << "  -p          Print the map" << std::endl;
+    std::cerr << "  -d          Enable debug mode" << std::endl;
+}
+
+static std::string defaultOutput(const std::string &input)
+{
+    size_t dot = input.find_last_of('.');
+    size_t slash = input.find_last_of('/');
+
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return input + ".smap";
+    return input.substr(0, dot) + ".smap";
+}
+
+static void printInfo(const std::string &path, const Map &map)
+{
+    std::cout << path << ": " << map.getWidth() << "x" << map.getHeight() << ", "
+              << map.getCoinCount() << " coins, " << map.getHazardCount() << " hazards" << std::endl;
+}
+
+// Same tiles and same index, column by column
+static bool sameMap(const Map &a, const Map &b)
+{
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight() ||
+        a.getCoinCount() != b.getCoinCount() || a.getHazardCount() != b.getHazardCount())
+        return false;
+
+    for (size_t x = 0; x < a.getWidth(); x++) {
+        std::span<const char> column_a = a.getColumn(x);
+        std::span<const char> column_b = b.getColumn(x);
+        std::span<const uint32_t> coins_a = a.getCoins(x);
+        std::span<const uint32_t> coins_b = b.getCoins(x);
+        std::span<const uint32_t> hazards_a = a.getHazards(x);
+        std::span<const uint32_t> hazards_b = b.getHazards(x);
+
+        if (!std::equal(column_a.begin(), column_a.end(), column_b.begin(), column_b.end()) ||
+            !std::equal(coins_a.begin(), coins_a.end(), coins_b.begin(), coins_b.end()) ||
+            !std::equal(hazards_a.begin(), hazards_a.end(), hazards_b.begin(), hazards_b.end()))
+            return false;
+    }
+    return true;
+}
+
+static bool verify(const std::string &path, Map &map)
+{
+    if (!map.loadFromFile(path)) {
+        std::cerr << path << ": " << map.getLastError() << std::endl;
+        return false;
+    }
+
+    if (!map.verifySmapChecksum()) {
+        std::cerr << path << ": not a .smap file or bad checksum" << std::endl;
+        return false;
+    }
+
+    Map rebuilt;
+
+    // The index stored in the file has to match the tiles
+    if (!rebuilt.loadFromData(map.serialize()) || !sameMap(map, rebuilt)) {
+        std::cerr << path << ": index does not match the tiles" << std::endl;
+        return false;
+    }
+
+    printInfo(path, map);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::string output;
+    bool verify_only = false;
+    bool print = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:vpd")) != -1) {
+        switch (opt) {
+            case 'o':
+                output = optarg;
+                break;
+            case 'v':
+                verify_only = true;
+                break;
+            case 'p':
+                print = true;
+                break;
+            case 'd':
+                g_logger.setDebugMode(true);
+                break;
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (optind + 1 != argc) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::string input = argv[optind];
+    Map source;
+    Map compiled;
+
+    if (verify_only)
+        return verify(input, compiled) ? 0 : 1;
+
+    if (!source.loadFromFile(input)) {
+        std::cerr << input << ": " << source.getLastError() << std::endl;
+        return 1;
+    }
+
+    printInfo(input, source);
+    if (print)
+        source.printMap();
+
+    if (output.empty())
+        output = defaultOutput(input);
+
+    if (!source.saveAsSmap(output)) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return 1;
+    }
+
+    if (!verify(output, compiled) || !sameMap(source, compiled)) {
+        std::cerr << output << ": does not match " << input << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << output << std::endl;
+    return 0;
+}
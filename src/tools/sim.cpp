@@ -0,0 +1,351 @@
+/*
+ ** EPITECH PROJECT, 2024
+ ** B-NWP-jetpack
+ ** File description:
+ ** JETPACK
+ */
+
+#include "../server/room.hpp"
+#include "../server/tick_scheduler.hpp"
+#include "../common/map.hpp"
+#include "../common/protocol.hpp"
+#include "../common/messages.hpp"
+#include "../common/debug.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <unistd.h>
+
+// Headless matches: the rooms of the server, fed with fake clients and
+// scripted or random input, without sockets, clients or sleeping. The
+// lobby phases are run first, only the game ticks are measured.
+
+//=============================================================================
+// Allocation counter
+//=============================================================================
+
+static size_t allocation_count = 0;
+
+void *operator new(size_t size)
+{
+    void *memory = std::malloc(size ? size : 1);
+
+    if (!memory)
+        throw std::bad_alloc();
+    allocation_count++;
+    return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+//=============================================================================
+// Fake clients
+//=============================================================================
+
+// Counts what the rooms send instead of sending it, and keeps the winner
+// each fake client was told
+class CountingSink : public RoomSink {
+public:
+    static constexpr int NOT_OVER = -1;
+
+    size_t packets = 0;
+    size_t bytes = 0;
+    std::vector<int> winners;   // by fd, NOT_OVER until MSG_GAME_END
+
+    void sendToClient(int client_fd, const SharedPacket &packet) override
+    {
+        GameEndMessage end;
+
+        packets++;
+        bytes += packet.size();
+
+        if (packet.size() == GameEndSchema::PACKET_SIZE && packet.data()[0] == MSG_GAME_END &&
+            static_cast<size_t>(client_fd) < winners.size() &&
+            GameEndSchema::decode(packet.data() + sizeof(MessageHeader), GameEndSchema::SIZE, end))
+            winners[client_fd] = end.winner;
+    }
+
+    void sendSnapshot(int, const SharedPacket &packet) override
+    {
+        packets++;
+        bytes += packet.size();
+    }
+};
+
+struct ScriptedInput {
+    uint64_t tick;
+    size_t player;
+    bool jet;
+};
+
+struct SimConfig {
+    std::string map_path;
+    size_t matches = 100;
+    size_t players_per_match = 2;
+    uint64_t max_ticks = 0;
+    uint32_t seed = 1;
+    uint8_t capabilities = CAP_DELTA_STATE;
+    std::string script_path;
+    int expected_winner = CountingSink::NOT_OVER;
+    bool debug_mode = false;
+};
+
+struct SimMatch {
+    std::unique_ptr<Room> room;
+    int first_fd;
+    uint32_t snapshots;
+    std::vector<bool> jet;
+};
+
+// Snapshots a fake client acknowledges lag this many ticks behind
+static const uint32_t ACK_DELAY = 2;
+
+// Out of 256, chance that a random player flips its jetpack on a tick
+static const uint32_t FLIP_CHANCE = 32;
+
+static uint32_t nextRandom(uint32_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// One "<tick> <player> <0|1>" per line, applied to every match
+static bool loadScript(const std::string &path, std::vector<ScriptedInput> &script)
+{
+    std::ifstream file(path);
+    ScriptedInput input;
+    int jet = 0;
+
+    if (!file)
+        return false;
+
+    while (file >> input.tick >> input.player >> jet) {
+        input.jet = jet != 0;
+        script.push_back(input);
+    }
+
+    std::stable_sort(script.begin(), script.end(),
+                     [](const ScriptedInput &a, const ScriptedInput &b) { return a.tick < b.tick; });
+    return file.eof();
+}
+
+void printUsage(const char *programme)
+{
+    std::cerr << "Usage: " << programme << " -m <map> [-n <matches>] [-r <players>] [-t <ticks>] [-s <seed>] [-i <script>] [-c <caps>] [-w <player>] [-d]" << std::endl;
+    std::cerr << "  -m <map>     Map file, text or .smap" << std::endl;
+    std::cerr << "  -n <matches> Matches played at once (default 100)" << std::endl;
+    std::cerr << "  -r <players> Players per match (default 2)" << std::endl;
+    std::cerr << "  -t <ticks>   Stop after that many game ticks (default: when every match is over)" << std::endl;
+    std::cerr << "  -s <seed>    Seed of the random input (default 1)" << std::endl;
+    std::cerr << "  -i <script>  Scripted input instead, lines of \"<tick> <player> <0|1>\"" << std::endl;
+    std::cerr << "  -c <caps>    Capabilities of the fake clients (default 1, delta game state)" << std::endl;
+    std::cerr << "  -w <player>  Exit 1 unless every match is won by that player number, 255 for no winner" << std::endl;
+    std::cerr << "  -d           Enable debug mode" << std::endl;
+}
+
+static bool parseArguments(int argc, char **argv, SimConfig &config)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:n:r:t:s:i:c:w:d")) != -1) {
+        switch (opt) {
+            case 'm':
+                config.map_path = optarg;
+                break;
+            case 'n':
+                config.matches = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'r':
+                config.players_per_match = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 't':
+                config.max_ticks = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 's':
+                config.seed = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'i':
+                config.script_path = optarg;
+                break;
+            case 'c':
+                config.capabilities = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'w':
+                config.expected_winner = std::atoi(optarg);
+                break;
+            case 'd':
+                config.debug_mode = true;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    return !config.map_path.empty() && config.matches > 0 &&
+           config.players_per_match >= 2 && config.players_per_match <= 255 && config.seed != 0;
+}
+
+//=============================================================================
+// Main
+//=============================================================================
+
+int main(int argc, char **argv)
+{
+    SimConfig config;
+    Map map;
+    CountingSink sink;
+    std::vector<ScriptedInput> script;
+    std::vector<SimMatch> matches;
+
+    if (!parseArguments(argc, argv, config)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    g_logger.setDebugMode(config.debug_mode);
+
+    if (!map.loadFromFile(config.map_path)) {
+        std::cerr << "T as chie la map mon reuf: " << config.map_path << " (" << map.getLastError() << ")" << std::endl;
+        return 1;
+    }
+
+    if (!config.script_path.empty() && !loadScript(config.script_path, script)) {
+        std::cerr << "Invalid script: " << config.script_path << std::endl;
+        return 1;
+    }
+
+    int next_fd = 0;
+    int tick_rate = TickScheduler::DEFAULT_TICK_RATE;
+
+    for (size_t i = 0; i < config.matches; i++) {
+        SimMatch match = {
+            std::make_unique<Room>(static_cast<int>(i), sink, map, config.players_per_match, tick_rate),
+            next_fd, 0, std::vector<bool>(config.players_per_match, false)
+        };
+
+        for (size_t p = 0; p < config.players_per_match; p++) {
+            match.room->addPlayer(next_fd);
+            match.room->setCapabilities(next_fd++, config.capabilities);
+        }
+        matches.push_back(std::move(match));
+    }
+    sink.winners.assign(next_fd, CountingSink::NOT_OVER);
+
+    // Lobby: every match fills at once, so they all start on the same tick
+    while (matches[0].room->getPhase() != Room::PHASE_RUNNING) {
+        for (SimMatch &match : matches)
+            match.room->update();
+    }
+
+    uint32_t random_state = config.seed;
+    uint64_t ticks = 0;
+    uint64_t player_ticks = 0;
+    size_t script_pos = 0;
+    size_t start_allocations = allocation_count;
+    size_t start_packets = sink.packets;
+    size_t start_bytes = sink.bytes;
+    auto start = std::chrono::steady_clock::now();
+
+    while (config.max_ticks == 0 || ticks < config.max_ticks) {
+        size_t running = 0;
+
+        for (SimMatch &match : matches) {
+            Room &room = *match.room;
+
+            if (room.getPhase() != Room::PHASE_RUNNING)
+                continue;
+
+            if (script.empty()) {
+                for (size_t p = 0; p < match.jet.size(); p++) {
+                    if ((nextRandom(random_state) & 0xFF) < FLIP_CHANCE) {
+                        match.jet[p] = !match.jet[p];
+                        room.handlePlayerInput(match.first_fd + p, match.jet[p]);
+                    }
+                }
+            } else {
+                for (size_t s = script_pos; s < script.size() && script[s].tick == ticks; s++) {
+                    if (script[s].player < match.jet.size())
+                        room.handlePlayerInput(match.first_fd + script[s].player, script[s].jet);
+                }
+            }
+
+            if (match.snapshots > ACK_DELAY) {
+                for (size_t p = 0; p < match.jet.size(); p++)
+                    room.handleStateAck(match.first_fd + p, match.snapshots - ACK_DELAY);
+            }
+
+            player_ticks += room.getPlayerCount();
+            room.update();
+            match.snapshots++;
+            running++;
+        }
+
+        while (script_pos < script.size() && script[script_pos].tick <= ticks)
+            script_pos++;
+
+        if (running == 0)
+            break;
+        ticks++;
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double nanoseconds = std::chrono::duration<double, std::nano>(elapsed).count();
+    size_t allocations = allocation_count - start_allocations;
+
+    std::cout << "matches:              " << config.matches << " x " << config.players_per_match << " players" << std::endl;
+    std::cout << "map:                  " << map.getWidth() << "x" << map.getHeight() << std::endl;
+    std::cout << "game ticks:           " << ticks << " in " << seconds << " s" << std::endl;
+
+    // Winners by player number, 0xFF for none, then the unfinished matches
+    std::vector<size_t> wins(257, 0);
+    size_t wrong_winner = 0;
+
+    for (const SimMatch &match : matches) {
+        int winner = sink.winners[match.first_fd];
+
+        wins[winner == CountingSink::NOT_OVER ? 256 : winner]++;
+        if (config.expected_winner != CountingSink::NOT_OVER && winner != config.expected_winner)
+            wrong_winner++;
+    }
+
+    std::cout << "winners:             ";
+    for (size_t winner = 0; winner < wins.size(); winner++) {
+        if (wins[winner] == 0)
+            continue;
+        if (winner == 256)
+            std::cout << " unfinished=" << wins[winner];
+        else if (winner == 0xFF)
+            std::cout << " none=" << wins[winner];
+        else
+            std::cout << " player" << winner << "=" << wins[winner];
+    }
+    std::cout << std::endl;
+
+    if (wrong_winner > 0) {
+        std::cerr << wrong_winner << " matches not won by " << config.expected_winner << std::endl;
+        return 1;
+    }
+    if (ticks == 0 || player_ticks == 0)
+        return 0;
+    std::cout << "ticks per second:     " << ticks / seconds << std::endl;
+    std::cout << "ns per player-tick:   " << nanoseconds / player_ticks << std::endl;
+    std::cout << "allocations per tick: " << static_cast<double>(allocations) / ticks << std::endl;
+    std::cout << "packets per tick:     " << static_cast<double>(sink.packets - start_packets) / ticks << std::endl;
+    std::cout << "bytes per tick:       " << static_cast<double>(sink.bytes - start_bytes) / ticks << std::endl;
+    return 0;
+}